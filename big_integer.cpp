@@ -12,31 +12,35 @@
 #include <algorithm>
 #include <cassert>
 #include <string>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <mutex>
 
 #include "big_integer.h"
 
 namespace ui {
-    big_integer::uint * alloc(int sz, big_integer::uint rf) {
-        big_integer::uint * ret = new big_integer::uint[sz + 1];
+    big_integer::limb * alloc(int sz, big_integer::limb rf) {
+        big_integer::limb * ret = new big_integer::limb[sz + 1];
         ret[0] = rf;
         ++ret;
         return ret;
     }
-    big_integer::uint * alloc_and_fill(int sz) {
-        big_integer::uint * ret = new big_integer::uint[sz];
+    big_integer::limb * alloc_and_fill(int sz) {
+        big_integer::limb * ret = new big_integer::limb[sz];
         for (int i = 0; i < sz; ++i) {
             ret[i] = 0;
         }
         return ret;
     }
-    void dealloc(big_integer::uint * ptr) {
+    void dealloc(big_integer::limb * ptr) {
         --ptr;
         delete[] ptr;
     }
-    void retain(big_integer::uint * ptr) {
+    void retain(big_integer::limb * ptr) {
         ++ptr[-1];
     }
-    void release(big_integer::uint * ptr) {
+    void release(big_integer::limb * ptr) {
         --ptr;
         ptr[0]--;
         if (ptr[0] == 0) {
@@ -46,6 +50,17 @@ namespace ui {
     }
 }
 
+int big_integer::karatsuba_threshold = 32;
+int big_integer::toom3_threshold = 1000;
+int big_integer::toom4_threshold = 3000;
+int big_integer::ntt_threshold = 6000;
+int big_integer::burnikel_ziegler_threshold = 40;
+int big_integer::newton_threshold = 150000;
+int big_integer::half_gcd_threshold = 100;
+int big_integer::parallel_product_threshold = 2000;
+int big_integer::decimal_threshold = 40;
+int big_divisor::reciprocal_threshold = 3000;
+
 big_integer::big_integer() {
     capacity = 1;
     small = 0LL;
@@ -58,7 +73,7 @@ void big_integer::ensure_capacity(int size) {
 }
 
 void big_integer::resize(int new_size) {
-    uint * tmp = ui::alloc(new_size, 1);
+    limb * tmp = ui::alloc(new_size, 1);
     for (int i = 0; i < size; ++i) {
         tmp[i] = elements[i];
     }
@@ -93,41 +108,16 @@ big_integer::big_integer(std::string const& str) {
             return;
         }
     }
-    std::vector<int> digits;
-    size = 0;
-    capacity = std::max((int)str.size(), 2);
-    elements = ui::alloc(capacity, 1);
-    for (int i = 0; i < capacity; ++i) {
-        elements[i] = 0;
-    }
-    for (size_t i = start_idx; i < str.size(); ++i) {
-        digits.push_back((int)str[i] - 48);
-    }
-    for (size_t iters = 0; iters < str.size(); ++iters) {
-        bool fail = true;
-        ll cur = 0LL;
-        for (size_t i = 0; i < digits.size(); ++i) {
-            cur = (cur * 10LL) + (ll)digits[i];
-            digits[i] = (int)(cur / BASE);
-            (digits[i] != 0 ? fail &= false : fail &= true);
-            cur %= BASE;
-        }
-        elements[size++] = (uint)cur;
-        if (fail) break;
+    capacity = 1;
+    small = 0LL;
+    big_integer result = parse_digits(str.data() + its_length, str.size() - its_length, 10);
+    if (sign < 0) {
+        result = -result;
     }
-    make_correct();
-    check_sign();
+    swap(result);
 }
 
 
-void negate_module(long long &x, long long &y) {
-    y = 0;
-    while(x < 0) {
-        x += big_integer::BASE;
-        ++y;
-    }
-}
-
 int compare_absolute_value(big_integer const& a, big_integer const& b) {
     if (a.capacity == 1 && b.capacity == 1) {
         if (std::abs(a.small) < std::abs(b.small)) {
@@ -137,29 +127,21 @@ int compare_absolute_value(big_integer const& a, big_integer const& b) {
         }
         return 0;
     }
-    if (a.capacity == 1 && b.size <= 2) {
-        big_integer::ll b_medium = 1LL * b.elements[0] + 1LL * big_integer::BASE * b.elements[1];
-        if (std::abs(a.small) < std::abs(b_medium)) {
+    if (a.capacity == 1) {
+        if (b.size > 1) {
             return -1;
-        } else if (std::abs(a.small) > std::abs(b.small)) {
-            return 1;
         }
-        return 0;
-    }
-    if (b.capacity == 1 && a.size <= 2) {
-        big_integer::ll a_medium = 1LL * a.elements[0] + 1LL * big_integer::BASE * a.elements[1];
-        if (std::abs(b.small) < std::abs(a_medium)) {
-            return 1;
-        } else if (std::abs(b.small) > std::abs(a_medium)) {
+        // |small| <= BASE fits into a single limb
+        big_integer::limb a_abs = (big_integer::limb)std::abs(a.small);
+        if (a_abs < b.elements[0]) {
             return -1;
+        } else if (a_abs > b.elements[0]) {
+            return 1;
         }
         return 0;
     }
-    if (a.capacity == 1) {
-        return -1;
-    }
     if (b.capacity == 1) {
-        return 1;
+        return -compare_absolute_value(b, a);
     }
     if (a.size < b.size) {
         return -1;
@@ -191,70 +173,12 @@ int compare(big_integer const& a, big_integer const& b) {
         }
         return 0;
     }
-    if (a.capacity == 1 && b.size <= 2) {
-        big_integer::ll b_medium = 1LL * b.elements[0] + 1LL * big_integer::BASE * b.elements[1];
-        if (b.sign == -1) b_medium *= -1LL;
-        if (a.small < b_medium) {
-            return -1;
-        } else if (a.small > b.small) {
-            return 1;
-        }
-        return 0;
-    }
-    if (b.capacity == 1 && a.size <= 2) {
-        big_integer::ll a_medium = 1LL * a.elements[0] + 1LL * big_integer::BASE * a.elements[1];
-        if (a.sign == -1) a_medium *= -1;
-        if (b.small < a_medium) {
-            return 1;
-        } else if (b.small > a_medium) {
-            return -1;
-        }
-        return 0;
-    }
-    if (a.capacity == 1) {
-        if (a.small < 0 && b.sign == 1) {
-            return -1;
-        }
-        if (a.small > 0 && b.sign == -1) {
-            return 1;
-        }
-        return -1;
-    }
-    if (b.capacity == 1) {
-        if (b.small < 0 && a.sign == 1) {
-            return 1;
-        }
-        if (b.small > 0 && a.sign == -1) {
-            return -1;
-        }
-        return 1;
-    }
-    if (a.sign < b.sign) {
-        return -1;
-    }
-    if (a.sign > b.sign) {
-        return 1;
-    }
-    if (a.sign == -1) {
-        if (a.size < b.size) {
-            return 1;
-        }
-        if (a.size > b.size) {
-            return -1;
-        }
-        for (int i = a.size - 1; /* empty */; --i) {
-            if (a.elements[i] > b.elements[i]) {
-                return -1;
-            }
-            if (a.elements[i] < b.elements[i]) {
-                return 1;
-            }
-            if (i == 0) break;
-        }
-        return 0;
-    } else {
-        return compare_absolute_value(a, b);
+    int a_sign = (a.capacity == 1 ? (a.small < 0 ? -1 : 1) : a.sign);
+    int b_sign = (b.capacity == 1 ? (b.small < 0 ? -1 : 1) : b.sign);
+    if (a_sign != b_sign) {
+        return (a_sign < b_sign ? -1 : 1);
     }
+    return a_sign * compare_absolute_value(a, b);
 }
 
 bool operator==(big_integer const& a, big_integer const& b) {
@@ -333,10 +257,10 @@ big_integer &big_integer::operator+=(big_integer const &rhs) {
     }
     copy_on_write();
     if (rhs.capacity == 1) {
-        if (rhs.small > 0) {
-            return add_small(rhs.small);
+        if ((rhs.small < 0) == (sign < 0)) {
+            return add_small(std::abs(rhs.small));
         } else {
-            return sub_small(-rhs.small);
+            return sub_small(std::abs(rhs.small));
         }
     }
     if (sign == rhs.sign) {
@@ -354,18 +278,16 @@ big_integer &big_integer::operator+=(big_integer const &rhs) {
     return *this;
 }
 
+// |*this| += value, 0 <= value <= BASE, so value fits into a single limb
 big_integer &big_integer::add_small(big_integer::ll value) {
-    big_integer::ll carry = 0;
-    for (int i = 0; i < size; i++) {
-        carry += (1LL * elements[i]);
-        elements[i] = (uint)(carry % BASE);
-        carry /= BASE;
-        if (carry == 0) {
-            break;
-        }
+    ensure_capacity(size + 1);
+    limb carry = (limb)value;
+    for (int i = 0; i < size && carry != 0; i++) {
+        elements[i] += carry;
+        carry = (elements[i] < carry ? 1 : 0);
     }
     if (carry != 0) {
-        elements[size++] += (uint)carry;
+        elements[size++] = carry;
     }
     make_correct();
     check_sign();
@@ -378,34 +300,35 @@ big_integer &big_integer::add(big_integer const& rhs) {
         ensure_capacity(size + 1);
         return add_small(rhs.small);
     }
-    ensure_capacity(std::max(size, rhs.size) + 3);
-    ll cur = 0LL;
-    int max_size = std::max(size, rhs.size) + 2;
+    ensure_capacity(std::max(size, rhs.size) + 1);
+    dlimb cur = 0;
+    int max_size = std::max(size, rhs.size) + 1;
     for (int i = 0; i < max_size; ++i) {
-        if (i < size) cur += 1LL * elements[i];
-        if (i < rhs.size) cur += (1LL * rhs.elements[i]);
-        elements[i] = (uint)(cur % BASE);
-        cur /= BASE;
+        if (i < size) cur += elements[i];
+        if (i < rhs.size) cur += rhs.elements[i];
+        elements[i] = (limb)cur;
+        cur >>= LIMB_BITS;
     }
+    size = max_size;
     make_correct();
     check_sign();
     return *this;
 }
 
+// |*this| -= value, 0 <= value <= BASE; the sign flips if value > |*this|
 big_integer &big_integer::sub_small(big_integer::ll value) {
-    big_integer::ll decrement = value;
-    for (int i = 0; i < size; i++) {
-        big_integer::ll cur = elements[i] - decrement;
-        if (cur < 0LL) {
-            elements[i] = (uint)(cur + BASE);
-            decrement = 1LL;
-        } else {
-            elements[i] = (uint)(cur);
-            decrement = 0LL;
-        }
-        if (decrement == 0LL) {
-            break;
-        }
+    limb decrement = (limb)value;
+    if (size == 1 && elements[0] < decrement) {
+        elements[0] = decrement - elements[0];
+        sign *= -1;
+        make_correct();
+        check_sign();
+        return *this;
+    }
+    for (int i = 0; i < size && decrement != 0; i++) {
+        limb cur = elements[i];
+        elements[i] = cur - decrement;
+        decrement = (cur < decrement ? 1 : 0);
     }
     make_correct();
     check_sign();
@@ -417,21 +340,16 @@ big_integer &big_integer::sub(big_integer const& rhs) {
     if (rhs.capacity == 1) {
         return sub_small(rhs.small);
     }
-    ensure_capacity(std::max(size, rhs.size) + 2);
     bool decrement = false;
     for (int i = 0; i < size; ++i) {
         if (i >= rhs.size && !decrement) break;
         if (i >= rhs.size && decrement) {
-            if (elements[i] == 0) {
-                elements[i] = (uint)(BASE - 1LL);
-            } else {
-                --elements[i];
-                decrement = false;
-            }
+            decrement = (elements[i] == 0);
+            --elements[i];
         } else {
-            ll cur = 1LL * elements[i] - 1LL * rhs.elements[i] - 1LL * decrement;
-            if (cur < 0) cur += BASE, decrement = true; else decrement = false;
-            elements[i] = ((uint)(cur));
+            limb cur = elements[i], sub = rhs.elements[i];
+            elements[i] = cur - sub - (decrement ? 1 : 0);
+            decrement = (cur < sub || (cur == sub && decrement));
         }
     }
     make_correct();
@@ -470,10 +388,10 @@ big_integer &big_integer::operator-=(big_integer const &rhs) {
     }
     copy_on_write();
     if (rhs.capacity == 1) {
-        if (rhs.small < 0) {
-            return add_small(-rhs.small);
+        if ((rhs.small < 0) != (sign < 0)) {
+            return add_small(std::abs(rhs.small));
         } else {
-            return sub_small(rhs.small);
+            return sub_small(std::abs(rhs.small));
         }
     }
     if (sign != rhs.sign) {
@@ -529,11 +447,8 @@ big_integer big_integer::operator~() const {
         tmp.turn_big_mode();
         return tmp;
     }
-    tmp.copy_on_write();
     ++tmp;
-    tmp.sign *= -1;
-    tmp.make_correct();
-    return tmp;
+    return -tmp;
 }
 
 big_integer &big_integer::operator++() {
@@ -572,7 +487,7 @@ void big_integer::shift_left(int k) {
             return;
         }
         if (k <= 31) {
-            small <<= (1LL * k);
+            small *= (1LL << k);
             if (small >= LEFT_BORDER && small <= RIGHT_BORDER) {
                 return;
             }
@@ -583,444 +498,3080 @@ void big_integer::shift_left(int k) {
         }
     }
     copy_on_write();
-    int blocks = k / POWER;
-    k %= POWER;
+    int blocks = k / LIMB_BITS;
+    k %= LIMB_BITS;
     ensure_capacity(size + blocks + 1);
-    uint tmp = 0, shift = (uint)POWER - (uint)k;
-    uint mask = (1U << shift) - 1;
+    elements[size + blocks] = 0;
     for (int i = size - 1; i >= 0; --i) {
-        tmp = elements[i];
+        limb tmp = elements[i];
+        if (k != 0) {
+            elements[i + blocks + 1] |= (tmp >> (LIMB_BITS - k));
+        }
+        elements[i + blocks] = (tmp << k);
+    }
+    for (int i = 0; i < blocks; ++i) {
         elements[i] = 0;
-        elements[i + blocks + 1] |= (tmp >> shift);
-        elements[i + blocks] |= ((tmp & mask) << k);
     }
     size += blocks + 1;
     make_correct();
 }
 
+// rounds towards minus infinity, as the shift of a two's complement number does
 void big_integer::shift_right(int k) {
     if (capacity == 1) {
-        small >>= (1LL * k);
+        small = (k >= 63 ? (small < 0 ? -1LL : 0LL) : small >> k);
         return;
     }
     copy_on_write();
-    int blocks = k / POWER;
-    k %= POWER;
-    bool dec_one = ((elements[0] & ((1U << (uint)k) - 1)) != 0);
-    elements[0] >>= k;
-    for (int i = 1; i < size; ++i) {
-        elements[i - 1] |= (elements[i] & ((1U << (uint)k) - 1)) << (POWER - k);
-    }
-    int max_idx_possible = std::min(blocks, size);
-    for (int i = 0; i < size; ++i) {
-        if (i < max_idx_possible && elements[i] != 0) {
+    int blocks = k / LIMB_BITS;
+    k %= LIMB_BITS;
+    bool dec_one = false;
+    for (int i = 0; i < std::min(blocks, size); ++i) {
+        if (elements[i] != 0) {
             dec_one = true;
         }
-        elements[i] = (i + blocks < size ? elements[i + blocks] : 0);
+    }
+    if (blocks < size && k != 0 && (elements[blocks] << (LIMB_BITS - k)) != 0) {
+        dec_one = true;
+    }
+    for (int i = 0; i < size; ++i) {
+        limb cur = 0;
+        if (i + blocks < size) {
+            cur = elements[i + blocks] >> k;
+        }
+        if (k != 0 && i + blocks + 1 < size) {
+            cur |= elements[i + blocks + 1] << (LIMB_BITS - k);
+        }
+        elements[i] = cur;
     }
     if ((sign < 0) && (dec_one)) {
-        --(*this);
+        add_small(1);
+        return;
     }
     make_correct();
+    check_sign();
 }
 
-std::string to_string(big_integer const& a) { // TODO
-    if (a.capacity == 1) {
-        return std::to_string(a.small);
+namespace conversion {
+    typedef big_integer::limb limb;
+
+    const char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+    // 0-9, then a-z or A-Z for 10-35; 36 for anything else
+    int digit_value(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'z') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'Z') {
+            return c - 'A' + 10;
+        }
+        return 36;
+    }
+
+    // b for radix = 2^b, 0 otherwise
+    int power_of_two_bits(int radix) {
+        int bits = 0;
+        while ((1 << bits) < radix) {
+            ++bits;
+        }
+        return ((1 << bits) == radix ? bits : 0);
     }
-    int idx = a.size - 1;
-    big_integer::uint * tmp = new big_integer::uint[idx + 1];
-    for (int i = 0; i <= idx; ++i) {
-        tmp[i] = a.elements[i];
+
+    // digits per chunk of the quadratic conversion: the largest d with radix^d that fits into a limb
+    int chunk_digits(int radix, limb & chunk_base) {
+        int digits = 0;
+        chunk_base = 1;
+        while (chunk_base <= ~(limb)0 / (limb)radix) {
+            chunk_base *= (limb)radix;
+            ++digits;
+        }
+        return digits;
     }
-    std::string result = "";
+
+    // the process-wide powers radix^(chunk_digits 2^k), k = 0, 1, ..., for every radix; the reference
+    // counts of limbs are not atomic, so the cached values never leave the lock, only deep copies of them
+    std::mutex powers_mutex;
+    std::vector<big_integer> powers[37];
+
+    // values up to this many limbs are converted by to_chars in buffers on the stack
+    const int STACK_LIMBS = 16;
+}
+
+// the quadratic conversion: one pass over tmp[0, n) per chunk of digits, which leaves tmp zero;
+// writes the digits backwards, ending at end, and returns their number: no leading zeros, at least one
+size_t big_integer::write_chunks(limb * tmp, int n, int radix, char * end) {
+    limb chunk_base;
+    int chunk_digits = conversion::chunk_digits(radix, chunk_base);
+    int idx = n - 1;
+    char * result = end;
     while (true) {
         bool fail = true;
-        big_integer::ll cur = 0LL;
+        dlimb cur = 0;
         for (int i = idx; /*empty */; --i) {
-            cur = cur * big_integer::BASE + 1LL * tmp[i];
-            tmp[i] = (big_integer::uint)(cur / 10LL);
-            cur %= 10LL;
-            (tmp[i] != 0LL ? fail &= false : fail &= true);
+            cur = (cur << LIMB_BITS) | tmp[i];
+            tmp[i] = (limb)(cur / chunk_base);
+            cur %= chunk_base;
+            (tmp[i] != 0 ? fail &= false : fail &= true);
             if (i == 0) break;
         }
-        result += (char)(cur + 48);
+        limb chunk = (limb)cur;
+        for (int i = 0; i < chunk_digits && (!fail || chunk != 0); ++i) {
+            *--result = conversion::DIGITS[chunk % radix];
+            chunk /= radix;
+        }
         if (fail) break;
-        while (idx > 1 && tmp[idx] == 0) --idx;
+        while (idx > 0 && tmp[idx] == 0) --idx;
     }
-    result += (a.sign == -1 ? "-" : "");
-    std::reverse(result.begin(), result.end());
-    delete[] tmp;
-    return result;
+    if (result == end) {
+        *--result = '0';
+    }
+    return (size_t)(end - result);
 }
 
-big_integer operator+(big_integer a, big_integer const& b) {
-    a += b;
-    return a;
-}
-big_integer operator-(big_integer a, big_integer const& b) {
-    a -= b;
-    return a;
+// appends |a| with leading zeros up to pad digits
+void big_integer::write_chunks(big_integer const& a, int radix, size_t pad, std::string& out) {
+    limb storage;
+    int n;
+    limb const * value = limbs_of(a, storage, n);
+    std::vector<limb> tmp(value, value + n);
+    std::string digits((size_t)n * LIMB_BITS + 1, '0');
+    size_t count = write_chunks(&tmp[0], n, radix, &digits[0] + digits.size());
+    if (count < pad) {
+        out.append(pad - count, '0');
+    }
+    out.append(digits.end() - count, digits.end());
 }
 
-big_integer &big_integer::operator*=(big_integer const &rhs) {
-    if (capacity == 1 && rhs.capacity == 1) {
-        big_integer::ll new_small = small * rhs.small;
-        small = new_small;
-        if (new_small >= LEFT_BORDER && new_small <= RIGHT_BORDER) {
-            return *this;
-        } else {
-            turn_big_mode();
-            return *this;
-        }
+// copies of radix^(chunk_digits 2^i) for i <= k, extending the cache as needed
+std::vector<big_integer> big_integer::radix_powers(int radix, int k) {
+    std::lock_guard<std::mutex> lock(conversion::powers_mutex);
+    std::vector<big_integer>& cache = conversion::powers[radix];
+    if (cache.empty()) {
+        limb chunk_base;
+        conversion::chunk_digits(radix, chunk_base);
+        cache.push_back(from_limbs(&chunk_base, 1));
     }
-    if (capacity == 1) {
-        turn_big_mode();
-    }
-    if (rhs.capacity == 1) {
-        ensure_capacity(size + 2);
-        copy_on_write();
-        return mul_small(rhs.small);
-    }
-    sign *= rhs.sign;
-    uint * tmp = ui::alloc(size + rhs.size + 5, 1);
-    for (int i = 0; i < size + rhs.size + 5; ++i) {
-        tmp[i] = 0;
+    while ((int)cache.size() <= k) {
+        cache.push_back(cache.back() * cache.back());
     }
-    for (int i = 0; i < size; ++i) {
-        for (int j = 0; j < rhs.size; ++j) {
-            ll val = (1LL * elements[i] * rhs.elements[j]) + 1LL * tmp[i + j];
-            size_t idx = i + j;
-            tmp[idx] = ((uint)(val % BASE));
-            val /= BASE;
-            ++idx;
-            tmp[idx] += ((uint)(val));
-            while (1LL * tmp[idx] >= BASE) {
-                uint cnt = 0;
-                while (1LL * tmp[idx] >= BASE) {
-                    ++cnt;
-                    tmp[idx] -= BASE;
-                }
-                if (cnt == 0) break;
-                ++idx;
-                tmp[idx] += cnt;
-            }
-        }
+    std::vector<big_integer> result;
+    for (int i = 0; i <= k; ++i) {
+        result.push_back(cache[i].capacity == 1 ? cache[i] : from_limbs(cache[i].elements, cache[i].size));
     }
-    ui::release(elements);
-    elements = tmp;
-    size += rhs.size;
-    capacity = size + 1;
-    make_correct();
-    check_sign();
-    return *this;
+    return result;
 }
 
-void inverse_all(big_integer::uint * a, int sz, bool do_i_really_need_this_shit) {
-    if (!do_i_really_need_this_shit) return;
-    for (int i = 0; i < sz; ++i) {
-        a[i] ^= (big_integer::uint)(big_integer::BASE - 1);
+// appends a for 0 <= a < radix^(chunk_digits 2^(k+1)), with exactly that many digits if pad: the high and
+// the low halves of the digits are the quotient and the remainder of the division by powers[k]
+void big_integer::write_digits(big_integer const& a, int radix, int k, bool pad,
+                               std::vector<big_integer> const& powers, std::string& out) {
+    if (k < 0 || length(a) < decimal_threshold) {
+        limb chunk_base;
+        size_t chunk_digits = (size_t)conversion::chunk_digits(radix, chunk_base);
+        write_chunks(a, radix, pad ? chunk_digits << (k + 1) : 0, out);
+        return;
     }
-    big_integer::uint add = 1;
-    for (int i = 0; i < sz && add > 0; ++i) {
-        a[i] += add;
-        if (1LL * a[i] >= big_integer::BASE) {
-            a[i] -= (big_integer::uint)(big_integer::BASE);
-            add = 1;
-        } else {
-            add = 0;
-        }
+    std::pair<big_integer, big_integer> qr = divmod(a, powers[k]);
+    if (pad || qr.first != 0) {
+        write_digits(qr.first, radix, k - 1, pad, powers, out);
+        pad = true;
     }
+    write_digits(qr.second, radix, k - 1, pad, powers, out);
 }
 
-void subtract_division_result(big_integer::uint * a, big_integer::uint * b, int from, int to, big_integer::ll &carry, big_integer::ll denum,
-                              big_integer::ll &got) {
-    carry = 0LL;
-    long long dec;
-    for (int j = from; j <= to; j++) {
-        carry += (big_integer::ll)a[j] - b[j] * got;
-        denum = carry % big_integer::BASE;
-        carry /= big_integer::BASE;
-        negate_module(denum, dec);
-        carry -= dec;
-        a[j] = (big_integer::uint)denum;
-    }
-    if (carry != 0) {
-        a[++to] += static_cast<big_integer::uint>(carry);
-        big_integer::uint cnt = 0;
-        while (1LL * a[to] >= big_integer::BASE) {
-            a[to] -= (big_integer::uint)(big_integer::BASE);
-            ++cnt;
-        }
-        if (cnt > 0) {
-            a[++to] += cnt;
+// the number of digits of |a| in radix 2^bits
+size_t big_integer::bit_digits(big_integer const& a, int bits) {
+    return std::max(((size_t)bit_length(a) + bits - 1) / bits, (size_t)1);
+}
+
+// writes the bit_digits(a, bits) digits of |a| in radix 2^bits to out, straight from the limbs
+void big_integer::write_bits(big_integer const& a, int bits, char * out) {
+    limb storage;
+    int n;
+    limb const * value = limbs_of(a, storage, n);
+    limb mask = ((limb)1 << bits) - 1;
+    size_t count = bit_digits(a, bits);
+    for (size_t i = count; i-- > 0;) {
+        size_t offset = i * bits;
+        size_t index = offset / LIMB_BITS;
+        int shift = (int)(offset % LIMB_BITS);
+        limb digit = value[index] >> shift;
+        if (shift + bits > LIMB_BITS && (int)index + 1 < n) {
+            digit |= value[index + 1] << (LIMB_BITS - shift);
         }
+        *out++ = conversion::DIGITS[digit & mask];
     }
 }
 
-big_integer &big_integer::operator/=(big_integer const &rhs) {
-    if (rhs.capacity == 1 && rhs.small == 0) {
-        throw std::runtime_error("oops, division by zero :(");
-    }
-    if (capacity == 1 && rhs.capacity == 1) {
-        small /= rhs.small;
-        if (LEFT_BORDER <= small && small <= RIGHT_BORDER) {
-            return *this;
-        } else {
-            turn_big_mode();
-            return *this;
+// the value of digits[0, n) in the radix: chunks of chunk_digits digits are folded into the limbs by
+// a multiply-add pass each; longer strings as high * radix^(chunk_digits 2^k) + low with low the last
+// chunk_digits 2^k digits, the longest such power that leaves high non-empty
+big_integer big_integer::parse_digits(char const * digits, size_t n, int radix) {
+    limb chunk_base;
+    size_t chunk_digits = (size_t)conversion::chunk_digits(radix, chunk_base);
+    if (n <= chunk_digits * decimal_threshold) {
+        std::vector<limb> result(1, 0);
+        size_t first = n % chunk_digits;
+        for (size_t i = 0; i < n; first += chunk_digits) {
+            limb chunk = 0, scale = 1;
+            for (; i < first; ++i) {
+                chunk = chunk * radix + (limb)conversion::digit_value(digits[i]);
+                scale *= radix;
+            }
+            for (size_t j = 0; j < result.size(); ++j) {
+                dlimb cur = (dlimb)result[j] * scale + chunk;
+                result[j] = (limb)cur;
+                chunk = (limb)(cur >> LIMB_BITS);
+            }
+            if (chunk != 0) {
+                result.push_back(chunk);
+            }
         }
+        return from_limbs(&result[0], (int)result.size());
     }
-    if (capacity == 1) {
-        turn_big_mode();
+    int k = 0;
+    while ((chunk_digits << (k + 1)) < n) {
+        ++k;
     }
-    copy_on_write();
-    if (rhs.capacity == 1) {
-        return div_small(rhs.small);
+    return parse_digits(digits, n, radix, k, radix_powers(radix, k));
+}
+
+big_integer big_integer::parse_digits(char const * digits, size_t n, int radix, int k,
+                                      std::vector<big_integer> const& powers) {
+    limb chunk_base;
+    size_t chunk_digits = (size_t)conversion::chunk_digits(radix, chunk_base);
+    if (k < 0 || n <= chunk_digits * decimal_threshold) {
+        return parse_digits(digits, n, radix);
     }
-    if (rhs == 0) {
-        throw std::runtime_error("oops, division by zero :(");
+    size_t low = chunk_digits << k;
+    if (n <= low) {
+        return parse_digits(digits, n, radix, k - 1, powers);
     }
-    if (compare_absolute_value(*this, rhs) < 0) {
-        *this = 0;
-        return *this;
+    big_integer result = parse_digits(digits, n - low, radix, k - 1, powers);
+    result *= powers[k];
+    result += parse_digits(digits + n - low, low, radix, k - 1, powers);
+    return result;
+}
+
+// the value of digits[0, n) in radix 2^bits, written straight into the limbs
+big_integer big_integer::parse_bits(char const * digits, size_t n, int bits) {
+    std::vector<limb> result(n * bits / LIMB_BITS + 2, 0);
+    for (size_t i = 0; i < n; ++i) {
+        limb digit = (limb)conversion::digit_value(digits[n - 1 - i]);
+        size_t offset = i * bits;
+        size_t index = offset / LIMB_BITS;
+        int shift = (int)(offset % LIMB_BITS);
+        result[index] |= digit << shift;
+        if (shift + bits > LIMB_BITS) {
+            result[index + 1] |= digit >> (LIMB_BITS - shift);
+        }
     }
-    if (size == 1 && elements[0] == 0) {
-        return *this;
+    return from_limbs(&result[0], (int)result.size());
+}
+
+big_integer::big_integer(std::string const& str, int radix) {
+    if (radix < 2 || radix > 36) {
+        throw std::runtime_error("oops, radix out of range :(");
     }
-    big_integer copy = rhs;
-    if (rhs.capacity == 1) {
-        copy.turn_big_mode();
+    size_t start_idx = (!str.empty() && str[0] == '-' ? 1 : 0);
+    if (start_idx == str.size()) {
+        throw std::runtime_error("oops, no digits :(");
     }
-    int new_sign = sign * copy.sign;
-    int sz_before = copy.size;
-    copy.copy_on_write();
-    int tmp_size = size - copy.size + 3;
-    uint *tmp = ui::alloc(tmp_size, 1);
-    for (int i = 0; i < tmp_size; ++i) {
-        tmp[i] = 0;
+    for (size_t i = start_idx; i < str.size(); ++i) {
+        if (conversion::digit_value(str[i]) >= radix) {
+            throw std::runtime_error("oops, invalid digit :(");
+        }
     }
-    long double numerator;
-    big_integer::ll denumerator;
-    big_integer::ll carry, res;
-    sign = copy.sign = 1;
-    int was_sz = size;
-    copy <<= (POWER * (size - copy.size));
-    copy_on_write();
-    elements[size] = 0;
-    int max_size_allowed = std::max(sz_before - 1, 0);
-    for (int i = size - 1; i >= max_size_allowed; --i) {
-        int idx = i - sz_before + 1;
-        numerator = (i == 0 ? 0 : 1.0L * elements[i - 1]);
-        denumerator = (i == 0 ? 0 : 1LL * copy.elements[i - 1]);
-        numerator += (1.0L * BASE * BASE * elements[i + 1]);
-        numerator += (1LL * BASE * elements[i]);
-        denumerator += (1LL * BASE * copy.elements[i]) + 1;
-        tmp[idx] = (uint)((big_integer::ll)((numerator / denumerator)));
-        res = (big_integer::ll)tmp[idx];
-        subtract_division_result(elements, copy.elements, idx, i, carry, denumerator, res);
-        while ((size > 1) && (elements[size - 1] == 0)) {
-            --size;
-        }
-        res = 1LL;
-        if(*this >= copy) {
-            ++tmp[idx];
-            subtract_division_result(elements, copy.elements, idx, i, carry, denumerator, res);
-        }
-        for (int j = std::max(i - copy.size, 0); j < i; j++) {
-            copy.elements[j] = copy.elements[j + 1];
-        }
-        copy.elements[i] = 0;
-        copy.size--;
+    while (start_idx + 1 < str.size() && str[start_idx] == '0') {
+        ++start_idx;
     }
-    ui::release(elements);
-    sign = new_sign;
-    size = was_sz - sz_before + 1;
-    elements = tmp;
-    capacity = tmp_size;
-    make_correct();
-    check_sign();
-    return *this;
+    capacity = 1;
+    small = 0LL;
+    int bits = conversion::power_of_two_bits(radix);
+    char const * digits = str.data() + start_idx;
+    size_t n = str.size() - start_idx;
+    big_integer result = (bits != 0 ? parse_bits(digits, n, bits) : parse_digits(digits, n, radix));
+    if (str[0] == '-') {
+        result = -result;
+    }
+    swap(result);
 }
 
-big_integer &big_integer::operator<<=(int rhs) {
-    if (rhs < 0) {
-        shift_right(-rhs);
-    } else {
-        shift_left(rhs);
-    }
-    return *this;
+std::string to_string(big_integer const& a) {
+    return to_string(a, 10);
 }
 
-big_integer &big_integer::operator>>=(int rhs) {
-    if (rhs < 0) {
-        shift_left(-rhs);
-    } else {
-        shift_right(rhs);
+std::string to_string(big_integer const& a, int radix) {
+    if (radix < 2 || radix > 36) {
+        throw std::runtime_error("oops, radix out of range :(");
     }
-    return *this;
+    if (a.capacity == 1 && radix == 10) {
+        return std::to_string(a.small);
+    }
+    std::string result = (a < 0 ? "-" : "");
+    int bits = conversion::power_of_two_bits(radix);
+    if (bits != 0) {
+        size_t sign_length = result.size();
+        result.resize(sign_length + big_integer::bit_digits(a, bits));
+        big_integer::write_bits(a, bits, &result[sign_length]);
+        return result;
+    }
+    if (big_integer::length(a) < big_integer::decimal_threshold) {
+        big_integer::write_chunks(a, radix, 0, result);
+        return result;
+    }
+    // the smallest k with radix^(chunk_digits 2^(k+1)) > |a|, with some slack for the rounding of the logarithm
+    big_integer::limb chunk_base;
+    int chunk_digits = conversion::chunk_digits(radix, chunk_base);
+    double bits_per_chunk = chunk_digits * std::log2((double)radix) * 0.99;
+    int k = 0;
+    while (bits_per_chunk * (2 << k) < big_integer::bit_length(a)) {
+        ++k;
+    }
+    big_integer::write_digits(a < 0 ? -a : a, radix, k, false, big_integer::radix_powers(radix, k), result);
+    return result;
 }
 
-big_integer &big_integer::operator%=(big_integer const &rhs) {
-    big_integer ths = *this;
-    big_integer tmp = ths / rhs;
-    big_integer mult = tmp * rhs;
-    tmp = ths - mult;
-    *this = tmp;
-    return *this;
+big_integer operator+(big_integer a, big_integer const& b) {
+    a += b;
+    return a;
+}
+big_integer operator-(big_integer a, big_integer const& b) {
+    a -= b;
+    return a;
 }
 
-big_integer &big_integer::operator&=(big_integer const &rhs) {
-    if (capacity == 1 && rhs.capacity == 1) {
-        small &= rhs.small;
-        if (LEFT_BORDER <= small && small <= RIGHT_BORDER) {
-            return *this;
-        } else {
-            turn_big_mode();
-            return *this;
+namespace limbs {
+    typedef big_integer::limb limb;
+    typedef big_integer::dlimb dlimb;
+
+    const int BITS = big_integer::LIMB_BITS;
+
+    // r[0, n) = a[0, n) + b[0, n), returns the carry; r may alias a or b
+    limb add_n(limb * r, limb const * a, limb const * b, int n) {
+        limb carry = 0;
+        for (int i = 0; i < n; ++i) {
+            dlimb cur = (dlimb)a[i] + b[i] + carry;
+            r[i] = (limb)cur;
+            carry = (limb)(cur >> BITS);
         }
+        return carry;
     }
-    if (capacity == 1) {
-        turn_big_mode();
-    }
-    if (rhs.capacity == 1) {
-        copy_on_write();
-        big_integer::ll abs_taken = std::abs(rhs.small);
-        big_integer::ll first = (abs_taken % BASE), second = (abs_taken) / BASE;
-        if (rhs.small < 0LL) {
-            first ^= (BASE - 1LL);
-            second ^= (BASE - 1LL);
-        }
-        elements[0] &= first;
-        elements[1] &= second;
-        for (int i = 2; i < size; i++) {
-            elements[i] = 0;
+
+    // r[0, n) = a[0, n) - b[0, n), returns the borrow; r may alias a or b
+    limb sub_n(limb * r, limb const * a, limb const * b, int n) {
+        limb borrow = 0;
+        for (int i = 0; i < n; ++i) {
+            dlimb cur = (dlimb)a[i] - b[i] - borrow;
+            r[i] = (limb)cur;
+            borrow = (limb)(cur >> BITS) & 1;
         }
-        make_correct();
-        check_sign();
-        return *this;
+        return borrow;
     }
-    if (size < rhs.size) {
-        ensure_capacity(rhs.size);
+
+    // adds b[0, nb) to r[0, nr), nb <= nr; the sum must fit into nr limbs
+    void add_into(limb * r, int nr, limb const * b, int nb) {
+        limb carry = add_n(r, r, b, nb);
+        for (int i = nb; carry != 0; ++i) {
+            assert(i < nr);
+            ++r[i];
+            carry = (r[i] == 0);
+        }
     }
-    copy_on_write();
-    big_integer tmp = big_integer(rhs);
-    inverse_all(elements, size, sign == -1);
-    inverse_all(tmp.elements, tmp.size, tmp.sign == -1);
-    for (int i = 0; i < size; i++) {
-        uint x = elements[i], y = 0;
-        if (i < tmp.size) {
-            y = tmp.elements[i];
+
+    int cmp_n(limb const * a, limb const * b, int n) {
+        for (int i = n - 1; i >= 0; --i) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i] ? -1 : 1;
+            }
         }
-        elements[i] = (x & y);
+        return 0;
     }
-    if (sign != tmp.sign || sign != -1) {
-        sign = 1;
+
+    // r[0, n) -= 1, returns the borrow
+    limb sub_1(limb * r, int n) {
+        for (int i = 0; i < n; ++i) {
+            if (r[i]-- != 0) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    // r[0, n) = a[0, n) << k, 0 <= k < BITS, returns the bits shifted out; r may alias a
+    limb shl_n(limb * r, limb const * a, int n, int k) {
+        if (k == 0) {
+            for (int i = n - 1; i >= 0; --i) {
+                r[i] = a[i];
+            }
+            return 0;
+        }
+        limb out = a[n - 1] >> (BITS - k);
+        for (int i = n - 1; i > 0; --i) {
+            r[i] = (a[i] << k) | (a[i - 1] >> (BITS - k));
+        }
+        r[0] = a[0] << k;
+        return out;
+    }
+
+    // r[0, n) = a[0, n) >> k, 0 <= k < BITS; r may alias a
+    void shr_n(limb * r, limb const * a, int n, int k) {
+        if (k == 0) {
+            for (int i = 0; i < n; ++i) {
+                r[i] = a[i];
+            }
+            return;
+        }
+        for (int i = 0; i < n - 1; ++i) {
+            r[i] = (a[i] >> k) | (a[i + 1] << (BITS - k));
+        }
+        r[n - 1] = a[n - 1] >> k;
+    }
+
+    // q[0, n) = a[0, n) / v, returns the remainder; q may alias a or be null if only the remainder is needed
+    // v <= 2^31, so the limbs can be divided in 32-bit halves with single-word divisions
+    limb divrem_small(limb * q, limb const * a, int n, limb v) {
+        unsigned long long carry = 0, divisor = v;
+        for (int i = n - 1; i >= 0; --i) {
+            limb quotient = 0;
+            for (int shift = BITS - 32; shift >= 0; shift -= 32) {
+                unsigned long long cur = (carry << 32) | (unsigned long long)((a[i] >> shift) & 0xffffffffU);
+                quotient |= (limb)(cur / divisor) << shift;
+                carry = cur % divisor;
+            }
+            if (q != 0) {
+                q[i] = quotient;
+            }
+        }
+        return (limb)carry;
+    }
+
+    // r[0, n) -= a[0, n) * v, returns the borrow out of the top limb
+    limb submul_1(limb * r, limb const * a, int n, limb v) {
+        limb borrow = 0;
+        for (int i = 0; i < n; ++i) {
+            dlimb product = (dlimb)a[i] * v + borrow;
+            limb low = (limb)product;
+            borrow = (limb)(product >> BITS) + (r[i] < low ? 1 : 0);
+            r[i] -= low;
+        }
+        return borrow;
+    }
+
+    // r[0, n) += a[0, n) * v, returns the carry out of the top limb
+    limb addmul_1(limb * r, limb const * a, int n, limb v) {
+        limb carry = 0;
+        for (int i = 0; i < n; ++i) {
+            dlimb cur = (dlimb)a[i] * v + r[i] + carry;
+            r[i] = (limb)cur;
+            carry = (limb)(cur >> BITS);
+        }
+        return carry;
+    }
+
+    // r[0, n) = a[0, n) * v, returns the carry out of the top limb
+    limb mul_1(limb * r, limb const * a, int n, limb v) {
+        limb carry = 0;
+        for (int i = 0; i < n; ++i) {
+            dlimb cur = (dlimb)a[i] * v + carry;
+            r[i] = (limb)cur;
+            carry = (limb)(cur >> BITS);
+        }
+        return carry;
+    }
+
+    // the BITS bits of a[0, n) from bit h upwards
+    limb bits_from(limb const * a, int n, int h) {
+        int i = h / BITS, k = h % BITS;
+        limb low = (i < n ? a[i] >> k : 0);
+        limb high = (k != 0 && i + 1 < n ? a[i + 1] << (BITS - k) : 0);
+        return low | high;
+    }
+
+    // Lehmer's inner loop: for x = xh * 2^h + x', y = yh * 2^h + y' with 0 <= x', y' < 2^h, the product
+    // m = {m00, m01, m10, m11} of the Euclid steps whose quotients are already fixed by xh and yh;
+    // the step matrices are [1 q; 0 1] for x -= q * y and [1 0; q 1] for y -= q * x, so that
+    // x = m00 * x1 + m01 * y1, y = m10 * x1 + m11 * y1 for the reduced pair
+    void lehmer_matrix(limb xh, limb yh, limb * m) {
+        limb const top = ~(limb)0;
+        m[0] = m[3] = 1;
+        m[1] = m[2] = 0;
+        while (true) {
+            // x1 = m11 * x - m01 * y and y1 = m00 * y - m10 * x lie in [lo, hi) times 2^h
+            dlimb x_plus = (dlimb)m[3] * xh, x_minus = (dlimb)m[1] * yh;
+            dlimb y_plus = (dlimb)m[0] * yh, y_minus = (dlimb)m[2] * xh;
+            dlimb x_lo = (x_plus >= x_minus + m[1] ? x_plus - x_minus - m[1] : 0);
+            dlimb x_hi = x_plus + m[3] - x_minus;
+            dlimb y_lo = (y_plus >= y_minus + m[2] ? y_plus - y_minus - m[2] : 0);
+            dlimb y_hi = y_plus + m[0] - y_minus;
+            if (y_lo != 0 && x_lo / y_hi == x_hi / y_lo && x_lo / y_hi != 0) {
+                dlimb q = x_lo / y_hi;
+                dlimb m01 = m[1] + q * m[0], m11 = m[3] + q * m[2];
+                if (q > top || m01 > top || m11 > top) {
+                    break;
+                }
+                m[1] = (limb)m01;
+                m[3] = (limb)m11;
+            } else if (x_lo != 0 && y_lo / x_hi == y_hi / x_lo && y_lo / x_hi != 0) {
+                dlimb q = y_lo / x_hi;
+                dlimb m00 = m[0] + q * m[1], m10 = m[2] + q * m[3];
+                if (q > top || m00 > top || m10 > top) {
+                    break;
+                }
+                m[0] = (limb)m00;
+                m[2] = (limb)m10;
+            } else {
+                break;
+            }
+        }
+    }
+
+    // -1 / m mod B for an odd m, by Newton's iteration x' = x * (2 - m * x), which doubles the
+    // correct low bits; m * m = 1 mod 8 gives the first three
+    limb negated_inverse(limb m) {
+        limb x = m;
+        for (int bits = 3; bits < BITS; bits *= 2) {
+            x *= 2 - m * x;
+        }
+        return (limb)0 - x;
+    }
+
+    // Montgomery reduction: r[0, n) = t[0, 2n) / B^n mod m for t < m * B^n, an odd m and
+    // m_inverse = -1 / m mod B; t is destroyed, r may alias t
+    void redc(limb * r, limb * t, limb const * m, int n, limb m_inverse) {
+        // each pass clears t[i]; the carry into t[i + n + 1] waits for the next pass
+        limb carry = 0;
+        for (int i = 0; i < n; ++i) {
+            limb c = addmul_1(t + i, m, n, t[i] * m_inverse);
+            dlimb cur = (dlimb)t[i + n] + c + carry;
+            t[i + n] = (limb)cur;
+            carry = (limb)(cur >> BITS);
+        }
+        // carry * B^n + t[n, 2n) < 2m
+        if (carry != 0 || cmp_n(t + n, m, n) >= 0) {
+            sub_n(r, t + n, m, n);
+        } else {
+            for (int i = 0; i < n; ++i) {
+                r[i] = t[i + n];
+            }
+        }
+    }
+
+    // redc without branches on the data: the final subtraction is always done and its result selected by a mask;
+    // r must not overlap t
+    void redc_sec(limb * r, limb * t, limb const * m, int n, limb m_inverse) {
+        limb carry = 0;
+        for (int i = 0; i < n; ++i) {
+            limb c = addmul_1(t + i, m, n, t[i] * m_inverse);
+            dlimb cur = (dlimb)t[i + n] + c + carry;
+            t[i + n] = (limb)cur;
+            carry = (limb)(cur >> BITS);
+        }
+        limb borrow = sub_n(r, t + n, m, n);
+        limb keep = (limb)0 - (carry | (borrow ^ 1));
+        for (int i = 0; i < n; ++i) {
+            r[i] = (r[i] & keep) | (t[i + n] & ~keep);
+        }
+    }
+
+    // r[0, na) = |a[0, na) - b[0, nb)|, nb <= na; returns true if a < b
+    bool abs_diff(limb * r, limb const * a, int na, limb const * b, int nb) {
+        bool less = false;
+        bool top_zero = true;
+        for (int i = nb; i < na; ++i) {
+            if (a[i] != 0) {
+                top_zero = false;
+                break;
+            }
+        }
+        if (top_zero) {
+            less = cmp_n(a, b, nb) < 0;
+        }
+        if (less) {
+            sub_n(r, b, a, nb);
+        } else {
+            limb borrow = sub_n(r, a, b, nb);
+            for (int i = nb; i < na; ++i) {
+                r[i] = a[i] - borrow;
+                borrow = (a[i] < borrow);
+            }
+            return false;
+        }
+        for (int i = nb; i < na; ++i) {
+            r[i] = 0;
+        }
+        return true;
+    }
+
+    // r[0, na + nb) = a * b, r must not overlap with a or b
+    // column by column (Comba): the products of a column are summed into a double limb,
+    // its overflows are counted in a third limb, the carry is resolved once per column
+    void mul_basecase(limb * r, limb const * a, int na, limb const * b, int nb) {
+        dlimb carry = 0;
+        for (int k = 0; k < na + nb - 1; ++k) {
+            dlimb low = carry;
+            limb high = 0;
+            int to = std::min(k, na - 1);
+            for (int i = std::max(0, k - nb + 1); i <= to; ++i) {
+                dlimb product = (dlimb)a[i] * b[k - i];
+                low += product;
+                high += (low < product);
+            }
+            r[k] = (limb)low;
+            carry = (low >> BITS) | ((dlimb)high << BITS);
+        }
+        r[na + nb - 1] = (limb)carry;
+    }
+
+    // r[0, 2n) = a[0, n)^2, each cross term a[i] * a[j], i < j, is computed once and doubled
+    void sqr_basecase(limb * r, limb const * a, int n) {
+        dlimb carry = 0;
+        for (int k = 0; k < 2 * n - 1; ++k) {
+            dlimb low = 0;
+            limb high = 0;
+            int i = std::max(0, k - n + 1);
+            for (; i < k - i; ++i) {
+                dlimb product = (dlimb)a[i] * a[k - i];
+                low += product;
+                high += (low < product);
+            }
+            high = (high << 1) | (limb)(low >> (2 * BITS - 1));
+            low <<= 1;
+            if (i == k - i) {
+                dlimb product = (dlimb)a[i] * a[i];
+                low += product;
+                high += (low < product);
+            }
+            low += carry;
+            high += (low < carry);
+            r[k] = (limb)low;
+            carry = (low >> BITS) | ((dlimb)high << BITS);
+        }
+        r[2 * n - 1] = (limb)carry;
+    }
+
+    bool karatsuba_applies(int n) {
+        return n >= 4 && n >= big_integer::karatsuba_threshold;
+    }
+
+    bool toom3_applies(int n) {
+        return n >= 12 && n >= big_integer::toom3_threshold;
+    }
+
+    bool toom4_applies(int n) {
+        return n >= 16 && n >= big_integer::toom4_threshold;
+    }
+
+    // number of scratch limbs mul_karatsuba needs for n-limb operands
+    int karatsuba_scratch(int n) {
+        if (!karatsuba_applies(n)) {
+            return 0;
+        }
+        int h = (n + 1) / 2;
+        return 4 * h + std::max(karatsuba_scratch(h), 2 * h + 1);
+    }
+
+    // r holds z0 in [0, 2h) and z2 in [2h, 2n); adds (z0 + z2 - d) * B^h, or (z0 + z2 + d) * B^h if negative
+    void karatsuba_middle(limb * r, int n, int h, limb const * d, bool negative, limb * mid) {
+        for (int i = 0; i < 2 * h; ++i) {
+            mid[i] = r[i];
+        }
+        mid[2 * h] = 0;
+        add_into(mid, 2 * h + 1, r + 2 * h, 2 * (n - h));
+        if (negative) {
+            add_into(mid, 2 * h + 1, d, 2 * h);
+        } else {
+            limb borrow = sub_n(mid, mid, d, 2 * h);
+            mid[2 * h] -= borrow;
+        }
+        int mid_size = 2 * h + 1;
+        while (mid_size > 0 && mid[mid_size - 1] == 0) {
+            --mid_size;
+        }
+        add_into(r + h, 2 * n - h, mid, mid_size);
+    }
+
+    // r[0, 2n) = a[0, n) * b[0, n)
+    // a = a1 * B^h + a0, b = b1 * B^h + b0
+    // a * b = z2 * B^2h + (z0 + z2 - (a0 - a1)(b0 - b1)) * B^h + z0
+    void mul_karatsuba(limb * r, limb const * a, limb const * b, int n, limb * scratch) {
+        if (!karatsuba_applies(n)) {
+            mul_basecase(r, a, n, b, n);
+            return;
+        }
+        int h = (n + 1) / 2, l = n - h;
+        limb * da = scratch;
+        limb * db = da + h;
+        limb * d = db + h;
+        limb * next = d + 2 * h;
+        bool negative = abs_diff(da, a, h, a + h, l) != abs_diff(db, b, h, b + h, l);
+        mul_karatsuba(d, da, db, h, next);
+        mul_karatsuba(r, a, b, h, next);
+        mul_karatsuba(r + 2 * h, a + h, b + h, l, next);
+        karatsuba_middle(r, n, h, d, negative, next);
+    }
+
+    // r[0, 2n) = a[0, n)^2, same scratch layout as mul_karatsuba
+    void sqr_karatsuba(limb * r, limb const * a, int n, limb * scratch) {
+        if (!karatsuba_applies(n)) {
+            sqr_basecase(r, a, n);
+            return;
+        }
+        int h = (n + 1) / 2, l = n - h;
+        limb * da = scratch;
+        limb * d = da + 2 * h;
+        limb * next = d + 2 * h;
+        abs_diff(da, a, h, a + h, l);
+        sqr_karatsuba(d, da, h, next);
+        sqr_karatsuba(r, a, h, next);
+        sqr_karatsuba(r + 2 * h, a + h, l, next);
+        karatsuba_middle(r, n, h, d, false, next);
+    }
+
+    // Knuth's Algorithm D: q[0, nu - nd] = u[0, nu] / d[0, nd), the remainder is left in u[0, nd);
+    // d[nd - 1] must have its top bit set and u[nu - nd + 1, nu] < d, so that the quotient fits
+    void divrem(limb * q, limb * u, int nu, limb const * d, int nd) {
+        limb const d1 = d[nd - 1];
+        limb const d0 = (nd > 1 ? d[nd - 2] : 0);
+        dlimb const base = (dlimb)1 << BITS;
+        for (int j = nu - nd; j >= 0; --j) {
+            // the trial quotient from the top two limbs over d1 is at most two too large,
+            // testing it against d0 and the third limb leaves at most one
+            dlimb numerator = ((dlimb)u[j + nd] << BITS) | u[j + nd - 1];
+            dlimb qhat = numerator / d1;
+            dlimb rhat = numerator % d1;
+            limb u0 = (nd > 1 ? u[j + nd - 2] : 0);
+            while (qhat >= base || qhat * d0 > ((rhat << BITS) | u0)) {
+                --qhat;
+                rhat += d1;
+                if (rhat >= base) {
+                    break;
+                }
+            }
+            limb borrow = submul_1(u + j, d, nd, (limb)qhat);
+            limb top = u[j + nd];
+            u[j + nd] = top - borrow;
+            if (top < borrow) {
+                // qhat was still one too large, add the divisor back
+                --qhat;
+                u[j + nd] += add_n(u + j, u + j, d, nd);
+            }
+            q[j] = (limb)qhat;
+        }
+    }
+
+    // Moller-Granlund inverse of a limb d with its top bit set: floor((B^2 - 1) / d) - B
+    limb inverse_1(limb d) {
+        return (limb)((((dlimb)~d << BITS) | (limb)~(limb)0) / d);
+    }
+
+    // (u1 * B + u0) / d for u1 < d with a normalized d and its inverse v, returns the remainder
+    // the quotient estimate comes from one multiplication and needs at most two corrections
+    limb div_2by1(limb & q, limb u1, limb u0, limb d, limb v) {
+        dlimb p = (dlimb)v * u1 + (((dlimb)u1 << BITS) | u0);
+        limb q1 = (limb)(p >> BITS) + 1;
+        limb q0 = (limb)p;
+        limb r = u0 - q1 * d;
+        if (r > q0) {
+            --q1;
+            r += d;
+        }
+        if (r >= d) {
+            ++q1;
+            r -= d;
+        }
+        q = q1;
+        return r;
+    }
+
+    // a[0, n) mod d for any d > 0: 2-by-1 divisions by the normalized d, shifting a on the fly
+    limb mod_1(limb const * a, int n, limb d) {
+        int shift = 0;
+        while (((d << shift) >> (BITS - 1)) == 0) {
+            ++shift;
+        }
+        limb normalized = d << shift;
+        limb v = inverse_1(normalized);
+        limb r = (shift == 0 ? 0 : a[n - 1] >> (BITS - shift));
+        limb q;
+        for (int i = n - 1; i >= 0; --i) {
+            limb u = a[i] << shift;
+            if (shift != 0 && i > 0) {
+                u |= a[i - 1] >> (BITS - shift);
+            }
+            r = div_2by1(q, r, u, normalized, v);
+        }
+        return r >> shift;
+    }
+
+    // q[0, n) = (top * B^n + u[0, n)) / d for top < d, returns the remainder; q may be null
+    limb divrem_1_preinv(limb * q, limb const * u, int n, limb top, limb d, limb v) {
+        limb quotient;
+        for (int i = n - 1; i >= 0; --i) {
+            top = div_2by1(quotient, top, u[i], d, v);
+            if (q != 0) {
+                q[i] = quotient;
+            }
+        }
+        return top;
+    }
+}
+
+namespace powering {
+    typedef big_integer::limb limb;
+
+    const int BITS = big_integer::LIMB_BITS;
+
+    int bit_length(limb const * e, int n) {
+        while (n > 0 && e[n - 1] == 0) {
+            --n;
+        }
+        int bits = (n == 0 ? 0 : (n - 1) * BITS);
+        for (limb top = (n == 0 ? 0 : e[n - 1]); top != 0; top >>= 1) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    // bits [from, from + count) of e, count < BITS
+    limb bits_at(limb const * e, int from, int count) {
+        limb value = 0;
+        for (int i = count - 1; i >= 0; --i) {
+            value = (value << 1) | ((e[(from + i) / BITS] >> ((from + i) % BITS)) & 1);
+        }
+        return value;
+    }
+
+    // base^e by repeated squaring, e >= 0
+    big_integer pow(big_integer const& base, int e) {
+        big_integer result = 1, square = base;
+        for (; e != 0; e >>= 1) {
+            if (e & 1) {
+                result *= square;
+            }
+            if (e > 1) {
+                square *= square;
+            }
+        }
+        return result;
+    }
+
+    // window width for an exponent of the given length, a table of 2^(k - 1) odd powers pays off
+    // against the multiplications it saves
+    int window_size(int bits) {
+        return bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : bits > 7 ? 2 : 1;
+    }
+
+    // splits the exponent into odd digits of at most k bits, from the top: the result is
+    // digit[0], then for every next step squared squarings[s] times and multiplied by digit[s] unless it is 0
+    void sliding_windows(limb const * e, int bits, int k, std::vector<int> & squarings, std::vector<limb> & digits) {
+        int pending = 0;
+        for (int i = bits - 1; i >= 0; ) {
+            if (bits_at(e, i, 1) == 0) {
+                ++pending;
+                --i;
+                continue;
+            }
+            int j = std::max(i - k + 1, 0);
+            while (bits_at(e, j, 1) == 0) {
+                ++j;
+            }
+            squarings.push_back(pending + (i - j + 1));
+            digits.push_back(bits_at(e, j, i - j + 1));
+            pending = 0;
+            i = j - 1;
+        }
+        if (pending != 0) {
+            squarings.push_back(pending);
+            digits.push_back(0);
+        }
+    }
+
+    // x[0, n) = a^e for an n-limb residue a and e of the given bit length, bits > 0, in the ring of ctx:
+    // (ctx.*mul)(r, a, b, scratch) and (ctx.*sqr)(r, a, scratch) with scratch_limbs of scratch, r may alias a
+    template <class Context>
+    void window_pow(Context const& ctx, void (Context::*mul)(limb *, limb const *, limb const *, limb *) const,
+                    void (Context::*sqr)(limb *, limb const *, limb *) const, int n, int scratch_limbs,
+                    limb * x, limb const * a, limb const * e, int bits) {
+        int k = window_size(bits);
+        std::vector<int> squarings;
+        std::vector<limb> digits;
+        sliding_windows(e, bits, k, squarings, digits);
+
+        // table[t] = a^(2t + 1)
+        int entries = 1 << (k - 1);
+        limb * table = ui::alloc((entries + 1) * n + scratch_limbs, 1);
+        limb * square = table + entries * n;
+        limb * scratch = square + n;
+        for (int i = 0; i < n; ++i) {
+            table[i] = a[i];
+        }
+        if (entries > 1) {
+            (ctx.*sqr)(square, table, scratch);
+            for (int t = 1; t < entries; ++t) {
+                (ctx.*mul)(table + t * n, table + (t - 1) * n, square, scratch);
+            }
+        }
+        for (int i = 0; i < n; ++i) {
+            x[i] = table[(digits[0] >> 1) * n + i];
+        }
+        for (size_t s = 1; s < digits.size(); ++s) {
+            for (int c = 0; c < squarings[s]; ++c) {
+                (ctx.*sqr)(x, x, scratch);
+            }
+            if (digits[s] != 0) {
+                (ctx.*mul)(x, x, table + (digits[s] >> 1) * n, scratch);
+            }
+        }
+        ui::release(table);
+    }
+}
+
+namespace ntt {
+    typedef big_integer::uint uint;
+    typedef big_integer::limb limb;
+    typedef unsigned long long ull;
+
+    // three primes c * 2^k + 1 below 2^31, their product exceeds 2^90
+    const uint P1 = 2013265921U, G1 = 31U; // 15 * 2^27 + 1
+    const uint P2 = 1811939329U, G2 = 13U; // 27 * 2^26 + 1
+    const uint P3 = 469762049U, G3 = 3U;   // 7 * 2^26 + 1
+
+    // limbs are cut into 32-bit coefficients
+    const int PIECE_BITS = 32;
+    const int PIECES = big_integer::LIMB_BITS / PIECE_BITS;
+    const ull PIECE_MASK = 0xffffffffULL;
+
+    // convolution terms are below n * 2^64 < P1 * P2 * P3 for n <= 2^26
+    const int MAX_LENGTH = 1 << 26;
+
+    uint piece(limb const * a, int i) {
+        return (uint)(a[i / PIECES] >> (PIECE_BITS * (i % PIECES)));
+    }
+
+    // sub-transforms of this length (in elements) are done in place, level by level
+    const int BLOCK = 1 << 12;
+
+    template <uint P>
+    struct field {
+        static uint add(uint a, uint b) {
+            uint c = a + b;
+            return (c >= P ? c - P : c);
+        }
+        static uint sub(uint a, uint b) {
+            return (a >= b ? a - b : a + P - b);
+        }
+        static uint mul(uint a, uint b) {
+            return (uint)((ull)a * b % P);
+        }
+        static uint pow(uint a, ull e) {
+            uint result = 1;
+            for (; e != 0; e >>= 1) {
+                if (e & 1) {
+                    result = mul(result, a);
+                }
+                a = mul(a, a);
+            }
+            return result;
+        }
+    };
+
+    template <uint P, uint G>
+    struct transform {
+        typedef field<P> f;
+
+        // roots[h + i] = w^i, where w is a primitive 2h-th root of unity
+        std::vector<uint> roots, inverse_roots;
+
+        explicit transform(int n) : roots(n), inverse_roots(n) {
+            for (int h = 1; h < n; h <<= 1) {
+                uint w = f::pow(G, (P - 1) / (2 * h));
+                uint w_inv = f::pow(w, P - 2);
+                roots[h] = inverse_roots[h] = 1;
+                for (int i = 1; i < h; ++i) {
+                    roots[h + i] = f::mul(roots[h + i - 1], w);
+                    inverse_roots[h + i] = f::mul(inverse_roots[h + i - 1], w_inv);
+                }
+            }
+        }
+
+        // decimation in frequency, natural order in, bit-reversed order out
+        void forward(uint * a, int n) const {
+            if (n > BLOCK) {
+                int h = n / 2;
+                butterflies_dif(a, h);
+                forward(a, h);
+                forward(a + h, h);
+                return;
+            }
+            for (int h = n / 2; h >= 1; h >>= 1) {
+                for (int from = 0; from < n; from += 2 * h) {
+                    butterflies_dif(a + from, h);
+                }
+            }
+        }
+
+        // decimation in time, bit-reversed order in, natural order out, not scaled
+        void inverse(uint * a, int n) const {
+            if (n > BLOCK) {
+                int h = n / 2;
+                inverse(a, h);
+                inverse(a + h, h);
+                butterflies_dit(a, h);
+                return;
+            }
+            for (int h = 1; h < n; h <<= 1) {
+                for (int from = 0; from < n; from += 2 * h) {
+                    butterflies_dit(a + from, h);
+                }
+            }
+        }
+
+        void butterflies_dif(uint * a, int h) const {
+            uint const * w = &roots[h];
+            for (int i = 0; i < h; ++i) {
+                uint u = a[i], v = a[i + h];
+                a[i] = f::add(u, v);
+                a[i + h] = f::mul(f::sub(u, v), w[i]);
+            }
+        }
+
+        void butterflies_dit(uint * a, int h) const {
+            uint const * w = &inverse_roots[h];
+            for (int i = 0; i < h; ++i) {
+                uint u = a[i], v = f::mul(a[i + h], w[i]);
+                a[i] = f::add(u, v);
+                a[i + h] = f::sub(u, v);
+            }
+        }
+    };
+
+    // result[0, n) = a * b mod (P, x^n - 1), where a and b are read as na and nb 32-bit coefficients;
+    // a single forward transform if a and b are the same
+    template <uint P, uint G>
+    void convolve(std::vector<uint>& result, limb const * a, int na, limb const * b, int nb, int n) {
+        typedef field<P> f;
+        transform<P, G> t(n);
+        result.assign(n, 0);
+        for (int i = 0; i < na; ++i) {
+            result[i] = piece(a, i) % P;
+        }
+        t.forward(&result[0], n);
+        if (a == b && na == nb) {
+            for (int i = 0; i < n; ++i) {
+                result[i] = f::mul(result[i], result[i]);
+            }
+        } else {
+            std::vector<uint> other(n, 0);
+            for (int i = 0; i < nb; ++i) {
+                other[i] = piece(b, i) % P;
+            }
+            t.forward(&other[0], n);
+            for (int i = 0; i < n; ++i) {
+                result[i] = f::mul(result[i], other[i]);
+            }
+        }
+        t.inverse(&result[0], n);
+        uint n_inv = f::pow(n, P - 2);
+        for (int i = 0; i < n; ++i) {
+            result[i] = f::mul(result[i], n_inv);
+        }
+    }
+
+    bool applies(int na, int nb) {
+        return std::min(na, nb) >= big_integer::ntt_threshold && (na + nb) * PIECES - 1 <= MAX_LENGTH;
+    }
+
+    // r[0, na + nb) = a * b, r must not overlap with a or b
+    void mul(limb * r, limb const * a, int na, limb const * b, int nb) {
+        na *= PIECES;
+        nb *= PIECES;
+        int n = 1;
+        while (n < na + nb - 1) {
+            n <<= 1;
+        }
+        std::vector<uint> r1, r2, r3;
+        convolve<P1, G1>(r1, a, na, b, nb, n);
+        convolve<P2, G2>(r2, a, na, b, nb, n);
+        convolve<P3, G3>(r3, a, na, b, nb, n);
+
+        // Garner: x = t1 + t2 * P1 + t3 * P1 * P2
+        uint const p1_inv = field<P2>::pow(P1 % P2, P2 - 2);
+        uint const p1p2_inv = field<P3>::pow((uint)((ull)P1 * P2 % P3), P3 - 2);
+        ull const p1p2 = (ull)P1 * P2;
+        ull const p1p2_low = p1p2 & PIECE_MASK, p1p2_high = p1p2 >> PIECE_BITS;
+        for (int i = 0; i < (na + nb) / PIECES; ++i) {
+            r[i] = 0;
+        }
+        ull carry = 0;
+        for (int i = 0; i < na + nb; ++i) {
+            ull cur = carry;
+            carry = 0;
+            if (i < na + nb - 1) {
+                uint t1 = r1[i];
+                uint t2 = field<P2>::mul(field<P2>::sub(r2[i], t1 % P2), p1_inv);
+                uint low = (uint)(((ull)t2 * (P1 % P3) + t1) % P3);
+                uint t3 = field<P3>::mul(field<P3>::sub(r3[i], low), p1p2_inv);
+                cur += t1 + (ull)t2 * P1 + t3 * p1p2_low;
+                carry = t3 * p1p2_high;
+            }
+            r[i / PIECES] |= (limb)(cur & PIECE_MASK) << (PIECE_BITS * (i % PIECES));
+            carry += cur >> PIECE_BITS;
+        }
+        assert(carry == 0);
+    }
+}
+
+namespace toom {
+    // values of x[2] * t^2 + x[1] * t + x[0] in 0, 1, -1, -2 and infinity
+    void evaluate3(big_integer const * x, big_integer * v) {
+        big_integer even = x[0] + x[2];
+        v[0] = x[0];
+        v[1] = even + x[1];
+        v[2] = even - x[1];
+        v[3] = (v[2] + x[2]) * 2 - x[0];
+        v[4] = x[2];
+    }
+
+    // products in 0, 1, -1, -2 and infinity to the coefficients, in place; sequence by Bodrato
+    void interpolate3(big_integer * r) {
+        big_integer r3 = r[3] - r[1];
+        r3 /= 3;
+        r[1] -= r[2];
+        r[1] /= 2;
+        r[2] -= r[0];
+        r3 = r[2] - r3;
+        r3 /= 2;
+        r3 += r[4] * 2;
+        r[2] += r[1];
+        r[2] -= r[4];
+        r[1] -= r3;
+        r[3] = r3;
+    }
+
+    // values of x[3] * t^3 + ... + x[0] in 0, 1, -1, 2, -2, 3 and infinity
+    void evaluate4(big_integer const * x, big_integer * v) {
+        big_integer even = x[0] + x[2], odd = x[1] + x[3];
+        v[0] = x[0];
+        v[1] = even + odd;
+        v[2] = even - odd;
+        even = x[0] + x[2] * 4;
+        odd = x[1] * 2 + x[3] * 8;
+        v[3] = even + odd;
+        v[4] = even - odd;
+        v[5] = ((x[3] * 3 + x[2]) * 3 + x[1]) * 3 + x[0];
+        v[6] = x[3];
+    }
+
+    // products in 0, 1, -1, 2, -2, 3 and infinity to the coefficients c0..c6, in place
+    void interpolate4(big_integer * r) {
+        big_integer const& c0 = r[0];
+        big_integer const& c6 = r[6];
+
+        // c2 + c4 and c2 + 4 * c4
+        big_integer e1 = r[1] + r[2];
+        e1 /= 2;
+        e1 -= c0;
+        e1 -= c6;
+        big_integer e2 = r[3] + r[4];
+        e2 /= 2;
+        e2 -= c0;
+        e2 -= c6 * 64;
+        e2 /= 4;
+        big_integer c4 = e2 - e1;
+        c4 /= 3;
+        big_integer c2 = e1 - c4;
+
+        // c1 + c3 + c5, c1 + 4 * c3 + 16 * c5 and c1 + 9 * c3 + 81 * c5
+        big_integer o1 = r[1] - r[2];
+        o1 /= 2;
+        big_integer o2 = r[3] - r[4];
+        o2 /= 4;
+        big_integer o3 = r[5] - c0;
+        o3 -= c2 * 9;
+        o3 -= c4 * 81;
+        o3 -= c6 * 729;
+        o3 /= 3;
+        // c3 + 5 * c5 and c3 + 13 * c5
+        big_integer d1 = o2 - o1;
+        d1 /= 3;
+        big_integer d2 = o3 - o2;
+        d2 /= 5;
+        big_integer c5 = d2 - d1;
+        c5 /= 8;
+        big_integer c3 = d1 - c5 * 5;
+        big_integer c1 = o1 - c3;
+        c1 -= c5;
+
+        r[1] = c1;
+        r[2] = c2;
+        r[3] = c3;
+        r[4] = c4;
+        r[5] = c5;
+    }
+}
+
+big_integer big_integer::from_limbs(limb const * src, int n) {
+    while (n > 0 && src[n - 1] == 0) {
+        --n;
+    }
+    if (n == 0) {
+        return big_integer(0);
+    }
+    big_integer result;
+    result.capacity = n + 2;
+    result.elements = ui::alloc(result.capacity, 1);
+    for (int i = 0; i < n; ++i) {
+        result.elements[i] = src[i];
+    }
+    result.elements[n] = result.elements[n + 1] = 0;
+    result.size = n;
+    result.sign = 1;
+    return result;
+}
+
+// the limbs of |a|, at least one
+std::vector<big_integer::limb> big_integer::magnitude(big_integer const& a) {
+    if (a.capacity == 1) {
+        return std::vector<limb>(1, (limb)(a.small < 0 ? -a.small : a.small));
+    }
+    return std::vector<limb>(a.elements, a.elements + a.size);
+}
+
+// r[0, nr) += x, x must be non-negative
+void big_integer::add_shifted(limb * r, int nr, big_integer const& x) {
+    assert(x.capacity == 1 ? x.small >= 0 : x.sign == 1);
+    if (x.capacity == 1) {
+        limb value = (limb)x.small;
+        limbs::add_into(r, nr, &value, 1);
+        return;
+    }
+    limbs::add_into(r, nr, x.elements, std::min(x.size, nr));
+}
+
+// r[0, 2n) = a[0, n) * b[0, n), both split into k = 3 or 4 pieces of m limbs:
+// a(x) = a[k - 1] * x^(k - 1) + ... + a[0] with x = B^m, the same for b;
+// the 2k - 1 products of the values are interpolated into the coefficients of a(x) * b(x)
+void big_integer::mul_toom(limb * r, limb const * a, limb const * b, int n, int k) {
+    int m = (n + k - 1) / k;
+    int points = 2 * k - 1;
+    bool square = (a == b);
+    big_integer x[4], y[4], values[7], other[7];
+    for (int i = 0; i < k; ++i) {
+        int len = std::min(m, n - i * m);
+        x[i] = from_limbs(a + i * m, len);
+        if (!square) {
+            y[i] = from_limbs(b + i * m, len);
+        }
+    }
+    (k == 3 ? toom::evaluate3 : toom::evaluate4)(x, values);
+    if (!square) {
+        (k == 3 ? toom::evaluate3 : toom::evaluate4)(y, other);
+    }
+    for (int i = 0; i < points; ++i) {
+        values[i] *= (square ? values[i] : other[i]);
+    }
+    (k == 3 ? toom::interpolate3 : toom::interpolate4)(values);
+
+    for (int i = 0; i < 2 * n; ++i) {
+        r[i] = 0;
+    }
+    for (int i = 0; i < points; ++i) {
+        add_shifted(r + i * m, 2 * n - i * m, values[i]);
+    }
+}
+
+void big_integer::mul_balanced(limb * r, limb const * a, limb const * b, int n) {
+    if (limbs::toom4_applies(n)) {
+        mul_toom(r, a, b, n, 4);
+    } else if (limbs::toom3_applies(n)) {
+        mul_toom(r, a, b, n, 3);
+    } else {
+        limb * scratch = ui::alloc(limbs::karatsuba_scratch(n), 1);
+        if (a == b) {
+            limbs::sqr_karatsuba(r, a, n, scratch);
+        } else {
+            limbs::mul_karatsuba(r, a, b, n, scratch);
+        }
+        ui::release(scratch);
+    }
+}
+
+// r[0, na + nb) = a * b, r must not overlap with a or b; a == b with na == nb is squaring
+void big_integer::mul_limbs(limb * r, limb const * a, int na, limb const * b, int nb) {
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    bool square = (a == b && na == nb);
+    if (!limbs::karatsuba_applies(nb)) {
+        if (square) {
+            limbs::sqr_basecase(r, a, na);
+        } else {
+            limbs::mul_basecase(r, a, na, b, nb);
+        }
+        return;
+    }
+    if (ntt::applies(na, nb)) {
+        ntt::mul(r, a, na, b, nb);
+        return;
+    }
+    if (na == nb) {
+        mul_balanced(r, a, b, nb);
+        return;
+    }
+    // unbalanced operands: multiply b by nb-limb slices of a
+    limb * chunk = ui::alloc(2 * nb, 1);
+    for (int i = 0; i < na + nb; ++i) {
+        r[i] = 0;
+    }
+    for (int from = 0; from < na; from += nb) {
+        int len = std::min(nb, na - from);
+        if (len == nb) {
+            mul_balanced(chunk, a + from, b, nb);
+        } else {
+            mul_limbs(chunk, b, nb, a + from, len);
+        }
+        limbs::add_into(r + from, na + nb - from, chunk, len + nb);
+    }
+    ui::release(chunk);
+}
+
+big_integer &big_integer::operator*=(big_integer const &rhs) {
+    if (capacity == 1 && rhs.capacity == 1) {
+        big_integer::ll new_small = small * rhs.small;
+        small = new_small;
+        if (new_small >= LEFT_BORDER && new_small <= RIGHT_BORDER) {
+            return *this;
+        } else {
+            turn_big_mode();
+            return *this;
+        }
+    }
+    if (capacity == 1) {
+        turn_big_mode();
+    }
+    if (rhs.capacity == 1) {
+        ensure_capacity(size + 2);
+        copy_on_write();
+        return mul_small(rhs.small);
+    }
+    // x * x, also when x shares its buffer with a copy of itself
+    bool square = (elements == rhs.elements && size == rhs.size);
+    sign = (square ? 1 : sign * rhs.sign);
+    limb * tmp = ui::alloc(size + rhs.size + 5, 1);
+    mul_limbs(tmp, elements, size, square ? elements : rhs.elements, rhs.size);
+    for (int i = size + rhs.size; i < size + rhs.size + 5; ++i) {
+        tmp[i] = 0;
+    }
+    ui::release(elements);
+    elements = tmp;
+    size += rhs.size;
+    capacity = size + 1;
+    make_correct();
+    check_sign();
+    return *this;
+}
+
+// q[0, n) + qh * B^n = u[0, 2n) / d[0, n), returns qh; the remainder is left in u[0, n)
+// Burnikel-Ziegler: the high and the low halves of the quotient are each found by dividing by the
+// top half of d recursively and correcting with one multiplication by the bottom half;
+// d must be normalized, scratch holds n limbs
+big_integer::limb big_integer::div_recursive(limb * q, limb * u, limb const * d, int n, limb * scratch) {
+    if (n < std::max(burnikel_ziegler_threshold, 2)) {
+        limb qh = (limbs::cmp_n(u + n, d, n) >= 0 ? 1 : 0);
+        if (qh != 0) {
+            limbs::sub_n(u + n, u + n, d, n);
+        }
+        limbs::divrem(q, u, 2 * n - 1, d, n);
+        return qh;
+    }
+    int lo = n / 2, hi = n - lo;
+
+    limb qh = div_recursive(q + lo, u + 2 * lo, d + lo, hi, scratch);
+    mul_limbs(scratch, q + lo, hi, d, lo);
+    limb borrow = limbs::sub_n(u + lo, u + lo, scratch, n);
+    if (qh != 0) {
+        borrow += limbs::sub_n(u + n, u + n, d, lo);
+    }
+    while (borrow != 0) {
+        qh -= limbs::sub_1(q + lo, hi);
+        borrow -= limbs::add_n(u + lo, u + lo, d, n);
+    }
+
+    limb ql = div_recursive(q, u + hi, d + hi, lo, scratch);
+    mul_limbs(scratch, q, lo, d, hi);
+    borrow = limbs::sub_n(u, u, scratch, n);
+    if (ql != 0) {
+        borrow += limbs::sub_n(u + lo, u + lo, d, hi);
+    }
+    while (borrow != 0) {
+        limbs::sub_1(q, lo);
+        borrow -= limbs::add_n(u, u, d, n);
+    }
+    return qh;
+}
+
+// same contract as limbs::divrem; for large divisors the top qn % nd quotient limbs come from
+// the schoolbook division, the rest from div_recursive, nd limbs at a time
+void big_integer::div_limbs(limb * q, limb * u, int nu, limb const * d, int nd) {
+    if (nd < std::max(burnikel_ziegler_threshold, 2)) {
+        limbs::divrem(q, u, nu, d, nd);
+        return;
+    }
+    int qn = nu + 1 - nd;
+    int blocks = qn / nd;
+    int first = qn - blocks * nd;
+    if (first != 0) {
+        limbs::divrem(q + blocks * nd, u + blocks * nd, nd + first - 1, d, nd);
+    }
+    limb * scratch = ui::alloc(nd, 1);
+    for (int b = blocks - 1; b >= 0; --b) {
+        limb qh = div_recursive(q + b * nd, u + b * nd, d, nd, scratch);
+        assert(qh == 0);
+        (void)qh;
+    }
+    ui::release(scratch);
+}
+
+// floor(B^2n / d) for a normalized d[0, n), n + 1 limbs
+// Newton's iteration x' = x + x * (B^2n - d * x) / B^2n, started from the reciprocal of the top half of d
+big_integer big_integer::reciprocal(limb const * d, int n) {
+    if (n < std::max(newton_threshold, 3)) {
+        limb * u = ui::alloc(2 * n + 1, 1);
+        limb * q = ui::alloc(n + 1, 1);
+        for (int i = 0; i < 2 * n; ++i) {
+            u[i] = 0;
+        }
+        u[2 * n] = 1;
+        div_limbs(q, u, 2 * n, d, n);
+        big_integer result = from_limbs(q, n + 1);
+        ui::release(q);
+        ui::release(u);
+        return result;
+    }
+    int h = n / 2 + 1;
+    big_integer top = reciprocal(d + (n - h), h);
+    big_integer divisor = from_limbs(d, n);
+
+    // x = top * B^(n - h), e = B^2n - d * x; the low h - 2 limbs of e do not reach the correction
+    big_integer error = (big_integer(1) << (2 * n * LIMB_BITS)) - ((divisor * top) << ((n - h) * LIMB_BITS));
+    big_integer delta = (top * (error >> ((h - 2) * LIMB_BITS))) >> ((n + 2) * LIMB_BITS);
+    big_integer result = (top << ((n - h) * LIMB_BITS)) + delta;
+    error -= divisor * delta;
+    while (error < 0) {
+        --result;
+        error += divisor;
+    }
+    while (error >= divisor) {
+        ++result;
+        error -= divisor;
+    }
+    return result;
+}
+
+// same contract as limbs::divrem; the quotient is found nd limbs at a time, each block costs two
+// multiplications with the reciprocal of d, which is computed first unless inverse already holds it
+// or no block is long enough to use it
+void big_integer::div_newton(limb * q, limb * u, int nu, limb const * d, int nd, big_integer& inverse) {
+    if (inverse == 0 && nu + 1 - nd >= nd / 2) {
+        inverse = reciprocal(d, nd);
+    }
+    div_newton(q, u, nu, d, nd, static_cast<big_integer const&>(inverse));
+}
+
+// the same with a precomputed reciprocal, which is only read: it may be shared between threads
+void big_integer::div_newton(limb * q, limb * u, int nu, limb const * d, int nd, big_integer const& inverse) {
+    big_integer divisor = from_limbs(d, nd);
+    int qn = nu + 1 - nd;
+    for (int to = qn; to > 0; ) {
+        int from = std::max(to - nd, 0);
+        int r = to - from;
+        big_integer window = from_limbs(u + from, r + nd);
+        big_integer quotient;
+        if (r < nd / 2) {
+            // a short block: the top r + 1 limbs of d give the quotient or overestimate it by at most two
+            int k = nd - r - 1;
+            quotient = from_limbs(u + from + k, 2 * r + 1) / from_limbs(d + k, r + 1);
+            window -= quotient * divisor;
+            while (window < 0) {
+                --quotient;
+                window += divisor;
+            }
+        } else {
+            // (window / B^(nd - 1)) * reciprocal / B^(nd + 1) underestimates the quotient by at most three
+            quotient = (from_limbs(u + from + nd - 1, r + 1) * inverse) >> ((nd + 1) * LIMB_BITS);
+            window -= quotient * divisor;
+            while (window >= divisor) {
+                ++quotient;
+                window -= divisor;
+            }
+        }
+        for (int i = from; i < to; ++i) {
+            q[i] = 0;
+        }
+        add_shifted(q + from, r, quotient);
+        for (int i = from; i < to + nd; ++i) {
+            u[i] = 0;
+        }
+        add_shifted(u + from, nd, window);
+        to = from;
+    }
+}
+
+big_integer &big_integer::operator/=(big_integer const &rhs) {
+    if (rhs.capacity == 1 && rhs.small == 0) {
+        throw std::runtime_error("oops, division by zero :(");
+    }
+    if (capacity == 1 && rhs.capacity == 1) {
+        small /= rhs.small;
+        if (LEFT_BORDER <= small && small <= RIGHT_BORDER) {
+            return *this;
+        } else {
+            turn_big_mode();
+            return *this;
+        }
+    }
+    if (capacity == 1) {
+        turn_big_mode();
+    }
+    copy_on_write();
+    if (rhs.capacity == 1) {
+        return div_small(rhs.small);
+    }
+    big_integer quotient;
+    divide(*this, rhs, &quotient, 0);
+    swap(quotient);
+    return *this;
+}
+
+// *q = a / b rounded towards zero, *r = a - (a / b) * b; either pointer may be null
+void big_integer::divide(big_integer const& a, big_integer const& b, big_integer * q, big_integer * r) {
+    if (b == 0) {
+        throw std::runtime_error("oops, division by zero :(");
+    }
+    if (compare_absolute_value(a, b) < 0) {
+        if (q != 0) {
+            *q = 0;
+        }
+        if (r != 0) {
+            *r = a;
+        }
+        return;
+    }
+    if (b.capacity == 1 && a.capacity == 1) {
+        if (r != 0) {
+            *r = big_integer((int)(a.small % b.small));
+        }
+        if (q != 0) {
+            *q = a;
+            *q /= b;
+        }
+        return;
+    }
+    if (b.capacity == 1) {
+        // one pass of the single-limb kernel gives both the quotient and the remainder
+        limb *tmp = ui::alloc(a.size, 1);
+        limb *u = ui::alloc(1, 1);
+        u[0] = limbs::divrem_small(tmp, a.elements, a.size, (limb)std::abs(b.small));
+        store_division(tmp, a.size, u, 1, 0, (a.sign < 0) != (b.small < 0), a.sign < 0, q, r);
+        return;
+    }
+    if (a.capacity == 1) {
+        big_integer copy = a;
+        copy.turn_big_mode();
+        divide(copy, b, q, r);
+        return;
+    }
+    int nu = a.size, nd = b.size;
+    // normalize: shift both operands so that the top bit of the divisor is set, the quotient stays the same
+    int shift = 0;
+    while ((b.elements[nd - 1] << shift) >> (LIMB_BITS - 1) == 0) {
+        ++shift;
+    }
+    limb *d = ui::alloc(nd, 1);
+    limb *u = ui::alloc(nu + 1, 1);
+    limbs::shl_n(d, b.elements, nd, shift);
+    u[nu] = limbs::shl_n(u, a.elements, nu, shift);
+    limb *tmp = ui::alloc(nu - nd + 1, 1);
+    if (nd >= std::max(newton_threshold, 3)) {
+        big_integer inverse;
+        div_newton(tmp, u, nu, d, nd, inverse);
+    } else {
+        div_limbs(tmp, u, nu, d, nd);
+    }
+    store_division(tmp, nu - nd + 1, u, nd, shift, a.sign != b.sign, a.sign < 0, q, r);
+    ui::release(d);
+}
+
+// turns the output of the division kernels into results: quotient[0, qn) and the remainder u[0, nd),
+// still shifted left by shift bits; releases both buffers
+void big_integer::store_division(limb * quotient, int qn, limb * u, int nd, int shift, bool negative_quotient,
+                                 bool negative_remainder, big_integer * q, big_integer * r) {
+    if (q != 0) {
+        *q = from_limbs(quotient, qn);
+        if (negative_quotient) {
+            *q = -*q;
+        }
+    }
+    if (r != 0) {
+        limbs::shr_n(u, u, nd, shift);
+        *r = from_limbs(u, nd);
+        if (negative_remainder) {
+            *r = -*r;
+        }
+    }
+    ui::release(quotient);
+    ui::release(u);
+}
+
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b) {
+    std::pair<big_integer, big_integer> result;
+    big_integer::divide(a, b, &result.first, &result.second);
+    return result;
+}
+
+big_divisor::big_divisor(big_integer const& d) : divisor(d), shift(0), inverse_1(0) {
+    if (d == 0) {
+        throw std::runtime_error("oops, division by zero :(");
+    }
+    big_integer magnitude = d;
+    if (magnitude.capacity == 1) {
+        magnitude.turn_big_mode();
+    }
+    int nd = magnitude.size;
+    while ((magnitude.elements[nd - 1] << shift) >> (big_integer::LIMB_BITS - 1) == 0) {
+        ++shift;
+    }
+    normalized.resize(nd);
+    limbs::shl_n(&normalized[0], magnitude.elements, nd, shift);
+    if (nd == 1) {
+        inverse_1 = limbs::inverse_1(normalized[0]);
+    } else if (nd >= std::max(reciprocal_threshold, 3)) {
+        inverse = big_integer::reciprocal(&normalized[0], nd);
+    }
+}
+
+big_integer const& big_divisor::value() const {
+    return divisor;
+}
+
+big_integer big_divisor::div(big_integer const& a) const {
+    big_integer quotient;
+    divide(a, &quotient, 0);
+    return quotient;
+}
+
+big_integer big_divisor::mod(big_integer const& a) const {
+    big_integer remainder;
+    divide(a, 0, &remainder);
+    return remainder;
+}
+
+std::pair<big_integer, big_integer> big_divisor::divmod(big_integer const& a) const {
+    std::pair<big_integer, big_integer> result;
+    divide(a, &result.first, &result.second);
+    return result;
+}
+
+// the same steps as big_integer::divide, without normalizing the divisor again
+void big_divisor::divide(big_integer const& a, big_integer * q, big_integer * r) const {
+    if (a.capacity == 1 && divisor.capacity == 1) {
+        big_integer::divide(a, divisor, q, r);
+        return;
+    }
+    if (compare_absolute_value(a, divisor) < 0) {
+        if (q != 0) {
+            *q = 0;
+        }
+        if (r != 0) {
+            *r = a;
+        }
+        return;
+    }
+    if (a.capacity == 1) {
+        big_integer copy = a;
+        copy.turn_big_mode();
+        divide(copy, q, r);
+        return;
+    }
+    int nu = a.size, nd = (int)normalized.size();
+    limb const * d = &normalized[0];
+    limb *u = ui::alloc(nu + 1, 1);
+    u[nu] = limbs::shl_n(u, a.elements, nu, shift);
+    limb *tmp = ui::alloc(nu - nd + 1, 1);
+    if (nd == 1) {
+        u[0] = limbs::divrem_1_preinv(tmp, u, nu, u[nu], d[0], inverse_1);
+    } else if (inverse != 0) {
+        big_integer::div_newton(tmp, u, nu, d, nd, inverse);
+    } else {
+        big_integer::div_limbs(tmp, u, nu, d, nd);
+    }
+    big_integer::store_division(tmp, nu - nd + 1, u, nd, shift, (a < 0) != (divisor < 0), a < 0, q, r);
+}
+
+montgomery::montgomery(big_integer const& modulus) : m(modulus) {
+    if (modulus <= 0 || (modulus & 1) == 0) {
+        throw std::runtime_error("oops, Montgomery form needs an odd positive modulus :(");
+    }
+    big_integer magnitude = modulus;
+    if (magnitude.capacity == 1) {
+        magnitude.turn_big_mode();
+    }
+    n = magnitude.size;
+    m_limbs.assign(magnitude.elements, magnitude.elements + n);
+    m_inverse = limbs::negated_inverse(m_limbs[0]);
+    r2 = (big_integer(1) << (2 * n * big_integer::LIMB_BITS)) % m;
+}
+
+big_integer const& montgomery::modulus() const {
+    return m;
+}
+
+big_integer montgomery::to_montgomery(big_integer const& a) const {
+    big_integer reduced = a % m;
+    if (reduced < 0) {
+        reduced += m;
+    }
+    return mul(reduced, r2);
+}
+
+big_integer montgomery::from_montgomery(big_integer const& a) const {
+    limb * t = ui::alloc(2 * n, 1);
+    load(t, a);
+    for (int i = n; i < 2 * n; ++i) {
+        t[i] = 0;
+    }
+    limbs::redc(t, t, &m_limbs[0], n, m_inverse);
+    big_integer result = big_integer::from_limbs(t, n);
+    ui::release(t);
+    return result;
+}
+
+big_integer montgomery::mul(big_integer const& a, big_integer const& b) const {
+    limb * buffer = ui::alloc(4 * n, 1);
+    load(buffer, a);
+    load(buffer + n, b);
+    mul_n(buffer, buffer, buffer + n, buffer + 2 * n);
+    big_integer result = big_integer::from_limbs(buffer, n);
+    ui::release(buffer);
+    return result;
+}
+
+big_integer montgomery::sqr(big_integer const& a) const {
+    limb * buffer = ui::alloc(3 * n, 1);
+    load(buffer, a);
+    sqr_n(buffer, buffer, buffer + n);
+    big_integer result = big_integer::from_limbs(buffer, n);
+    ui::release(buffer);
+    return result;
+}
+
+// dst[0, n) = a, 0 <= a < m
+void montgomery::load(limb * dst, big_integer const& a) const {
+    assert(a >= 0 && a < m);
+    if (a.capacity == 1) {
+        dst[0] = (limb)a.small;
+        for (int i = 1; i < n; ++i) {
+            dst[i] = 0;
+        }
+        return;
+    }
+    for (int i = 0; i < n; ++i) {
+        dst[i] = (i < a.size ? a.elements[i] : 0);
+    }
+}
+
+// r[0, n) = a * b / R mod m with scratch[0, 2n); r may alias a or b
+void montgomery::mul_n(limb * r, limb const * a, limb const * b, limb * scratch) const {
+    big_integer::mul_limbs(scratch, a, n, b, n);
+    limbs::redc(r, scratch, &m_limbs[0], n, m_inverse);
+}
+
+void montgomery::sqr_n(limb * r, limb const * a, limb * scratch) const {
+    big_integer::mul_limbs(scratch, a, n, a, n);
+    limbs::redc(r, scratch, &m_limbs[0], n, m_inverse);
+}
+
+// mul_n by rows of addmul_1 and redc_sec, neither branches on the limbs; r must not overlap scratch
+void montgomery::mul_sec(limb * r, limb const * a, limb const * b, limb * scratch) const {
+    for (int i = 0; i < 2 * n; ++i) {
+        scratch[i] = 0;
+    }
+    for (int i = 0; i < n; ++i) {
+        scratch[i + n] = limbs::addmul_1(scratch + i, a, n, b[i]);
+    }
+    limbs::redc_sec(r, scratch, &m_limbs[0], n, m_inverse);
+}
+
+big_integer montgomery::pow(big_integer const& a, big_integer const& e) const {
+    if (e < 0) {
+        throw std::runtime_error("oops, negative exponent :(");
+    }
+    std::vector<limb> exponent = big_integer::magnitude(e);
+    int bits = powering::bit_length(&exponent[0], (int)exponent.size());
+    if (bits == 0) {
+        return to_montgomery(1);
+    }
+    limb * buffer = ui::alloc(2 * n, 1);
+    load(buffer, a);
+    powering::window_pow(*this, &montgomery::mul_n, &montgomery::sqr_n, n, 2 * n, buffer + n, buffer,
+                         &exponent[0], bits);
+    big_integer result = big_integer::from_limbs(buffer + n, n);
+    ui::release(buffer);
+    return result;
+}
+
+big_integer montgomery::pow_sec(big_integer const& a, big_integer const& e) const {
+    if (e < 0) {
+        throw std::runtime_error("oops, negative exponent :(");
+    }
+    std::vector<limb> exponent = big_integer::magnitude(e);
+    int bits = (int)exponent.size() * big_integer::LIMB_BITS;
+    int k = std::min(powering::window_size(bits), 4);
+
+    // table[t] = a^t, all of them, so that every window costs one multiplication
+    int entries = 1 << k;
+    limb * table = ui::alloc((entries + 4) * n, 1);
+    limb * x = table + entries * n;
+    limb * w = x + n;
+    limb * scratch = w + n;
+    for (int i = 0; i < 2 * n; ++i) {
+        scratch[i] = 0;
+    }
+    load(scratch, r2);
+    limbs::redc(table, scratch, &m_limbs[0], n, m_inverse);
+    load(table + n, a);
+    for (int t = 2; t < entries; ++t) {
+        mul_sec(table + t * n, table + (t - 1) * n, table + n, scratch);
+    }
+    for (int i = 0; i < n; ++i) {
+        x[i] = table[i];
+    }
+    for (int i = bits; i > 0; ) {
+        int count = (i % k == 0 ? k : i % k);
+        i -= count;
+        for (int c = 0; c < count; ++c) {
+            mul_sec(x, x, x, scratch);
+        }
+        limb digit = powering::bits_at(&exponent[0], i, count);
+        for (int j = 0; j < n; ++j) {
+            w[j] = 0;
+        }
+        for (int t = 0; t < entries; ++t) {
+            limb diff = (limb)t ^ digit;
+            limb mask = ((diff | ((limb)0 - diff)) >> (big_integer::LIMB_BITS - 1)) - 1;
+            for (int j = 0; j < n; ++j) {
+                w[j] |= table[t * n + j] & mask;
+            }
+        }
+        mul_sec(x, x, w, scratch);
+    }
+    big_integer result = big_integer::from_limbs(x, n);
+    ui::release(table);
+    return result;
+}
+
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod) {
+    if (mod == 0) {
+        throw std::runtime_error("oops, division by zero :(");
+    }
+    if (exp < 0) {
+        throw std::runtime_error("oops, negative exponent :(");
+    }
+    big_integer m = (mod < 0 ? -mod : mod);
+    if ((m & 1) != 0) {
+        montgomery ctx(m);
+        return ctx.from_montgomery(ctx.pow(ctx.to_montgomery(base), exp));
+    }
+
+    barrett ctx(m);
+    return ctx.pow(ctx.reduce(base), exp);
+}
+
+big_integer powmod_sec(big_integer const& base, big_integer const& exp, big_integer const& mod) {
+    montgomery ctx(mod < 0 ? -mod : mod);
+    return ctx.from_montgomery(ctx.pow_sec(ctx.to_montgomery(base), exp));
+}
+
+barrett::barrett(big_integer const& modulus) : m(modulus) {
+    if (modulus <= 0) {
+        throw std::runtime_error("oops, Barrett reduction needs a positive modulus :(");
+    }
+    m_limbs = big_integer::magnitude(modulus);
+    k = (int)m_limbs.size();
+    // mu has k + 1 limbs, k + 2 only for m = B^(k - 1)
+    mu = big_integer::magnitude((big_integer(1) << (2 * k * big_integer::LIMB_BITS)) / m);
+}
+
+big_integer const& barrett::modulus() const {
+    return m;
+}
+
+big_integer barrett::reduce(big_integer const& x) const {
+    std::vector<limb> value = big_integer::magnitude(x);
+    int length = (int)value.size();
+    limb * buffer = ui::alloc(3 * k + scratch_limbs(), 1);
+    limb * r = buffer;
+    limb * t = r + k;
+    limb * scratch = t + 2 * k;
+    for (int i = 0; i < k; ++i) {
+        r[i] = 0;
+    }
+    // the top 2k limbs, then Horner's scheme over chunks of at most k limbs: r * B^c + chunk < m * B^k
+    for (int to = length, from = std::max(length - 2 * k, 0); ; to = from, from = std::max(to - k, 0)) {
+        int c = to - from;
+        for (int i = 0; i < 2 * k; ++i) {
+            t[i] = (i < c ? value[from + i] : i - c < k ? r[i - c] : 0);
+        }
+        reduce_n(r, t, scratch);
+        if (from == 0) {
+            break;
+        }
+    }
+    big_integer result = big_integer::from_limbs(r, k);
+    ui::release(buffer);
+    if (x < 0 && result != 0) {
+        result = m - result;
+    }
+    return result;
+}
+
+big_integer barrett::mul(big_integer const& a, big_integer const& b) const {
+    limb * buffer = ui::alloc(2 * k + scratch_limbs(), 1);
+    load(buffer, a);
+    load(buffer + k, b);
+    mul_n(buffer, buffer, buffer + k, buffer + 2 * k);
+    big_integer result = big_integer::from_limbs(buffer, k);
+    ui::release(buffer);
+    return result;
+}
+
+big_integer barrett::sqr(big_integer const& a) const {
+    limb * buffer = ui::alloc(k + scratch_limbs(), 1);
+    load(buffer, a);
+    sqr_n(buffer, buffer, buffer + k);
+    big_integer result = big_integer::from_limbs(buffer, k);
+    ui::release(buffer);
+    return result;
+}
+
+big_integer barrett::pow(big_integer const& a, big_integer const& e) const {
+    if (e < 0) {
+        throw std::runtime_error("oops, negative exponent :(");
+    }
+    std::vector<limb> exponent = big_integer::magnitude(e);
+    int bits = powering::bit_length(&exponent[0], (int)exponent.size());
+    if (bits == 0) {
+        return reduce(1);
+    }
+    limb * buffer = ui::alloc(2 * k, 1);
+    load(buffer, a);
+    powering::window_pow(*this, &barrett::mul_n, &barrett::sqr_n, k, scratch_limbs(), buffer + k, buffer,
+                         &exponent[0], bits);
+    big_integer result = big_integer::from_limbs(buffer + k, k);
+    ui::release(buffer);
+    return result;
+}
+
+// scratch of mul_n and sqr_n: the 2k-limb product, then the two products of reduce_n and its (k + 1)-limb difference
+int barrett::scratch_limbs() const {
+    return 2 * k + 2 * (int)mu.size() + 3 * k + 2;
+}
+
+// dst[0, k) = a, 0 <= a < m
+void barrett::load(limb * dst, big_integer const& a) const {
+    assert(a >= 0 && a < m);
+    std::vector<limb> value = big_integer::magnitude(a);
+    for (int i = 0; i < k; ++i) {
+        dst[i] = (i < (int)value.size() ? value[i] : 0);
+    }
+}
+
+// r[0, k) = x[0, 2k) mod m
+void barrett::reduce_n(limb * r, limb const * x, limb * scratch) const {
+    int nmu = (int)mu.size();
+    limb * q2 = scratch;
+    limb * r2 = q2 + (k + 1) + nmu;
+    limb * t = r2 + nmu + k;
+    // q3 = floor(floor(x / B^(k - 1)) * mu / B^(k + 1)) is at most two below x / m
+    big_integer::mul_limbs(q2, x + (k - 1), k + 1, &mu[0], nmu);
+    big_integer::mul_limbs(r2, q2 + (k + 1), nmu, &m_limbs[0], k);
+    // so x - q3 * m < 3m fits into k + 1 limbs, and both sides can be taken mod B^(k + 1)
+    limbs::sub_n(t, x, r2, k + 1);
+    while (t[k] != 0 || limbs::cmp_n(t, &m_limbs[0], k) >= 0) {
+        t[k] -= limbs::sub_n(t, t, &m_limbs[0], k);
+    }
+    for (int i = 0; i < k; ++i) {
+        r[i] = t[i];
+    }
+}
+
+// r[0, k) = a * b mod m; r may alias a or b
+void barrett::mul_n(limb * r, limb const * a, limb const * b, limb * scratch) const {
+    big_integer::mul_limbs(scratch, a, k, b, k);
+    reduce_n(r, scratch, scratch + 2 * k);
+}
+
+void barrett::sqr_n(limb * r, limb const * a, limb * scratch) const {
+    big_integer::mul_limbs(scratch, a, k, a, k);
+    reduce_n(r, scratch, scratch + 2 * k);
+}
+
+// the state of a gcd reduction: the pair (a, b) and, if tracked, the matrix m with (a0; b0) = m (a; b) for the
+// starting pair, det m = 1; without full, only the bottom row is kept: a = m11 * a0 - m01 * b0 and
+// b = m00 * b0 - m10 * a0, so m10 and m11 are the cofactors of a0.
+// the entries of m never exceed max(a0, b0), so all buffers are sized once from the starting pair and every
+// step writes into a scratch row and swaps pointers; lengths are kept normalized
+struct big_integer::reduction {
+    int capacity;
+    limb * a;
+    limb * b;
+    int na, nb;
+    limb * m[4];
+    int nm[4];
+    bool tracked, full;
+    // t0, t1 and u are as wide as a, b and the matrix entries, so that they can trade places with them
+    limb * t0;
+    limb * t1;
+    limb * u;
+    limb * q;
+    limb * d;
+    limb * product;
+    std::vector<limb> storage;
+
+    reduction(limb const * a0, int na0, limb const * b0, int nb0, bool tracked, bool full)
+            : capacity(std::max(std::max(na0, nb0), 1)), tracked(tracked), full(full) {
+        int width = capacity + 1;
+        int entries = (tracked ? (full ? 4 : 2) : 0);
+        // a, b, t0, t1, u, q, d, the matrix entries and a product of two numbers below B^capacity
+        storage.assign((size_t)(9 + entries) * width, 0);
+        limb * next = &storage[0];
+        a = take(next, width);
+        b = take(next, width);
+        t0 = take(next, width);
+        t1 = take(next, width);
+        u = take(next, width);
+        q = take(next, width);
+        d = take(next, width);
+        product = take(next, 2 * width);
+        for (int i = 0; i < 4; ++i) {
+            m[i] = (tracked && (full || i >= 2) ? take(next, width) : 0);
+            nm[i] = 0;
+        }
+        if (tracked) {
+            if (full) {
+                m[0][0] = 1;
+                nm[0] = 1;
+            }
+            m[3][0] = 1;
+            nm[3] = 1;
+        }
+        na = load(a, a0, na0);
+        nb = load(b, b0, nb0);
+    }
+
+    static limb * take(limb *& next, int n) {
+        limb * result = next;
+        next += n;
+        return result;
+    }
+
+    static int normalize(limb const * x, int n) {
+        while (n > 0 && x[n - 1] == 0) {
+            --n;
+        }
+        return n;
+    }
+
+    static int load(limb * dst, limb const * src, int n) {
+        for (int i = 0; i < n; ++i) {
+            dst[i] = src[i];
+        }
+        return normalize(dst, n);
+    }
+
+    // dst = v for 0 <= v < B^capacity
+    static int load(limb * dst, big_integer const& v) {
+        limb low;
+        int n;
+        limb const * src = limbs_of(v, low, n);
+        return load(dst, src, n);
+    }
+};
+
+// the limbs of |a|: its own buffer, or storage for small values
+big_integer::limb const * big_integer::limbs_of(big_integer const& a, limb & storage, int & n) {
+    if (a.capacity == 1) {
+        storage = (limb)(a.small < 0 ? -a.small : a.small);
+        n = 1;
+        return &storage;
+    }
+    n = a.size;
+    return a.elements;
+}
+
+// the number of significant limbs of |a|
+int big_integer::length(big_integer const& a) {
+    if (a.capacity == 1) {
+        return (a.small == 0 ? 0 : 1);
+    }
+    return a.size;
+}
+
+// r = x * u + y * v, or x * u - y * v if subtract, which must not be negative; r has room for
+// max(nx, ny) + 1 limbs and must not overlap x or y; returns the normalized length
+int big_integer::combine(limb * r, limb const * x, int nx, limb u, limb const * y, int ny, limb v, bool subtract) {
+    int n = std::max(nx, ny) + 1;
+    for (int i = nx + 1; i < n; ++i) {
+        r[i] = 0;
+    }
+    r[nx] = limbs::mul_1(r, x, nx, u);
+    if (subtract) {
+        limb borrow = limbs::submul_1(r, y, ny, v);
+        for (int i = ny; borrow != 0; ++i) {
+            assert(i < n);
+            limb cur = r[i];
+            r[i] -= borrow;
+            borrow = (cur < borrow ? 1 : 0);
+        }
+    } else {
+        limb carry = limbs::addmul_1(r, y, ny, v);
+        limbs::add_into(r + ny, n - ny, &carry, 1);
+    }
+    return reduction::normalize(r, n);
+}
+
+// r += x * y for the result below B^capacity, r zero-padded by the caller up to the returned length;
+// a single-limb x goes through addmul_1, longer ones through the product scratch
+void big_integer::add_product(reduction& state, limb * r, int & nr, limb const * x, int nx, limb const * y, int ny) {
+    if (nx == 0 || ny == 0) {
+        return;
+    }
+    limb const * addend = state.product;
+    int n;
+    if (nx == 1 || ny == 1) {
+        limb v = (nx == 1 ? x[0] : y[0]);
+        limb const * w = (nx == 1 ? y : x);
+        int nw = (nx == 1 ? ny : nx);
+        n = std::max(nr, nw) + 1;
+        for (int i = nr; i < n; ++i) {
+            r[i] = 0;
+        }
+        limb carry = limbs::addmul_1(r, w, nw, v);
+        limbs::add_into(r + nw, n - nw, &carry, 1);
+        nr = reduction::normalize(r, n);
+        return;
+    }
+    mul_limbs(state.product, x, nx, y, ny);
+    int np = reduction::normalize(addend, nx + ny);
+    n = std::max(nr, np) + 1;
+    for (int i = nr; i < n; ++i) {
+        r[i] = 0;
+    }
+    limbs::add_into(r, n, addend, np);
+    nr = reduction::normalize(r, n);
+}
+
+// a Lehmer step on the leading limbs of a, b > 0, keeping both above s limbs;
+// updates m to m * step, returns false if no step was possible
+bool big_integer::lehmer_step(reduction& state, int s) {
+    limb const * al = state.a;
+    limb const * bl = state.b;
+    int na = state.na, nb = state.nb;
+    limb top = (na > nb ? al[na - 1] : na < nb ? bl[nb - 1] : std::max(al[na - 1], bl[nb - 1]));
+    int bits = std::max(na, nb) * LIMB_BITS;
+    for (; (top >> (LIMB_BITS - 1)) == 0; top <<= 1) {
+        --bits;
+    }
+    int h = std::max(bits - LIMB_BITS, 0);
+    limb step[4];
+    limbs::lehmer_matrix(limbs::bits_from(al, na, h), limbs::bits_from(bl, nb, h), step);
+    if (step[1] == 0 && step[2] == 0) {
+        return false;
+    }
+    int na1 = combine(state.t0, al, na, step[3], bl, nb, step[1], true);
+    int nb1 = combine(state.t1, bl, nb, step[0], al, na, step[2], true);
+    if (s > 0 && (na1 <= s || nb1 <= s)) {
+        return false;
+    }
+    std::swap(state.a, state.t0);
+    std::swap(state.b, state.t1);
+    state.na = na1;
+    state.nb = nb1;
+    if (state.tracked) {
+        for (int row = (state.full ? 0 : 2); row < 4; row += 2) {
+            limb * x = state.m[row];
+            limb * y = state.m[row + 1];
+            int nx = state.nm[row], ny = state.nm[row + 1];
+            int n0 = combine(state.t0, x, nx, step[0], y, ny, step[2], false);
+            int n1 = combine(state.t1, x, nx, step[1], y, ny, step[3], false);
+            std::swap(state.m[row], state.t0);
+            std::swap(state.m[row + 1], state.t1);
+            state.nm[row] = n0;
+            state.nm[row + 1] = n1;
+        }
+    }
+    return true;
+}
+
+// one Euclid step on a, b > 0 by a full division: the larger one is reduced modulo the smaller, with the
+// quotient one smaller if the remainder would not stay above s limbs; returns false if no step keeps that
+bool big_integer::subdiv_step(reduction& state, int s) {
+    bool reduce_a = (state.na != state.nb ? state.na > state.nb : limbs::cmp_n(state.a, state.b, state.na) >= 0);
+    limb *& x = (reduce_a ? state.a : state.b);
+    int & nx = (reduce_a ? state.na : state.nb);
+    limb const * y = (reduce_a ? state.b : state.a);
+    int ny = (reduce_a ? state.nb : state.na);
+    // normalize as in divide, the remainder is left in u
+    int shift = 0;
+    while ((y[ny - 1] << shift) >> (LIMB_BITS - 1) == 0) {
+        ++shift;
+    }
+    limb * u = state.u;
+    limbs::shl_n(state.d, y, ny, shift);
+    u[nx] = limbs::shl_n(u, x, nx, shift);
+    if (ny >= std::max(newton_threshold, 3)) {
+        big_integer inverse;
+        div_newton(state.q, u, nx, state.d, ny, inverse);
+    } else {
+        div_limbs(state.q, u, nx, state.d, ny);
+    }
+    limbs::shr_n(u, u, ny, shift);
+    int nq = reduction::normalize(state.q, nx - ny + 1);
+    int nr = reduction::normalize(u, ny);
+    if (s > 0 && nr <= s) {
+        if (nq == 1 && state.q[0] == 1) {
+            return false;
+        }
+        limbs::sub_1(state.q, nq);
+        nq = reduction::normalize(state.q, nq);
+        for (int i = nr; i <= ny; ++i) {
+            u[i] = 0;
+        }
+        u[ny] = limbs::add_n(u, u, y, ny);
+        nr = reduction::normalize(u, ny + 1);
+    }
+    std::swap(x, state.u);
+    nx = nr;
+    if (state.tracked) {
+        // reducing a adds q times the first column to the second, reducing b the other way round
+        int from = (reduce_a ? 0 : 1), to = 1 - from;
+        if (state.full) {
+            add_product(state, state.m[to], state.nm[to], state.q, nq, state.m[from], state.nm[from]);
+        }
+        add_product(state, state.m[2 + to], state.nm[2 + to], state.q, nq, state.m[2 + from], state.nm[2 + from]);
+    }
+    return true;
+}
+
+// the half-gcd of Moller's "On Schonhage's algorithm and subquadratic integer gcd computation": for a, b
+// with at most n limbs, reduces them by a full m (det 1) as far as possible while both stay above s = n / 2 + 1
+// limbs; the recursion on the top limbs returns matrices that are also valid for the full numbers
+bool big_integer::hgcd(reduction& state) {
+    int n = std::max(state.na, state.nb);
+    int s = n / 2 + 1;
+    if (std::min(state.na, state.nb) <= s) {
+        return false;
+    }
+    bool success = false;
+    if (n >= std::max(half_gcd_threshold, 4)) {
+        success = hgcd_reduce(state, n / 2, s);
+        int n2 = (3 * n) / 4 + 1;
+        while (std::max(state.na, state.nb) > n2) {
+            if (!lehmer_step(state, s) && !subdiv_step(state, s)) {
+                return success;
+            }
+            success = true;
+        }
+        n = std::max(state.na, state.nb);
+        if (n > s + 2 && hgcd_reduce(state, 2 * s - n + 1, s)) {
+            success = true;
+        }
+    }
+    while (lehmer_step(state, s) || subdiv_step(state, s)) {
+        success = true;
+    }
+    return success;
+}
+
+// runs hgcd on a, b without their low p limbs and applies the matrix to the full numbers;
+// false if it made no progress or the result does not stay above s limbs
+bool big_integer::hgcd_reduce(reduction& state, int p, int s) {
+    reduction step(state.a + p, std::max(state.na - p, 0), state.b + p, std::max(state.nb - p, 0), true, true);
+    if (!hgcd(step)) {
+        return false;
+    }
+    // the matrix products of the recursion are done on big_integers:
+    // m11 * a - m01 * b = ah' * B^p + m11 * a_low - m01 * b_low, and the same for b
+    big_integer m00 = from_limbs(step.m[0], step.nm[0]), m01 = from_limbs(step.m[1], step.nm[1]);
+    big_integer m10 = from_limbs(step.m[2], step.nm[2]), m11 = from_limbs(step.m[3], step.nm[3]);
+    big_integer a_low = from_limbs(state.a, std::min(p, state.na));
+    big_integer b_low = from_limbs(state.b, std::min(p, state.nb));
+    big_integer a1 = (from_limbs(step.a, step.na) << (p * LIMB_BITS)) + m11 * a_low - m01 * b_low;
+    big_integer b1 = (from_limbs(step.b, step.nb) << (p * LIMB_BITS)) + m00 * b_low - m10 * a_low;
+    if (a1 < 0 || b1 < 0 || (s > 0 && (length(a1) <= s || length(b1) <= s))) {
+        return false;
+    }
+    state.na = reduction::load(state.a, a1);
+    state.nb = reduction::load(state.b, b1);
+    if (state.tracked) {
+        // m = m * step
+        for (int row = (state.full ? 0 : 2); row < 4; row += 2) {
+            big_integer x = from_limbs(state.m[row], state.nm[row]);
+            big_integer y = from_limbs(state.m[row + 1], state.nm[row + 1]);
+            state.nm[row] = reduction::load(state.m[row], x * m00 + y * m10);
+            state.nm[row + 1] = reduction::load(state.m[row + 1], x * m01 + y * m11);
+        }
+    }
+    return true;
+}
+
+// reduces a, b >= 0 until one of them is zero, the other is then their gcd
+void big_integer::euclid(reduction& state) {
+    while (state.na != 0 && state.nb != 0) {
+        int n = std::max(state.na, state.nb);
+        if (n == 1 && !state.tracked) {
+            limb u = state.a[0], v = state.b[0];
+            while (v != 0) {
+                limb r = u % v;
+                u = v;
+                v = r;
+            }
+            state.a[0] = u;
+            state.na = 1;
+            state.nb = 0;
+            return;
+        }
+        if (std::min(state.na, state.nb) < n - 1) {
+            subdiv_step(state, 0);
+        } else if (n >= half_gcd_threshold) {
+            // the top third of the limbs gives a reduction by about a sixth of the length
+            if (!hgcd_reduce(state, (2 * n) / 3, 0)) {
+                subdiv_step(state, 0);
+            }
+        } else if (!lehmer_step(state, 0)) {
+            subdiv_step(state, 0);
+        }
+    }
+}
+
+big_integer gcd(big_integer const& x, big_integer const& y) {
+    big_integer::limb xs, ys;
+    int nx, ny;
+    big_integer::limb const * xl = big_integer::limbs_of(x, xs, nx);
+    big_integer::limb const * yl = big_integer::limbs_of(y, ys, ny);
+    big_integer::reduction state(xl, nx, yl, ny, false, false);
+    big_integer::euclid(state);
+    return (state.nb == 0 ? big_integer::from_limbs(state.a, state.na) : big_integer::from_limbs(state.b, state.nb));
+}
+
+// gcd(a, b) for a, b >= 0 and s with s * a = gcd(a, b) mod b, |s| <= b / 2gcd(a, b) for b > 0
+big_integer big_integer::gcd_cofactor(big_integer const& a, big_integer const& b, big_integer& s) {
+    limb as, bs;
+    int na, nb;
+    limb const * al = limbs_of(a, as, na);
+    limb const * bl = limbs_of(b, bs, nb);
+    reduction state(al, na, bl, nb, true, false);
+    euclid(state);
+    big_integer g;
+    if (state.nb == 0) {
+        g = from_limbs(state.a, state.na);
+        s = from_limbs(state.m[3], state.nm[3]);
+    } else {
+        g = from_limbs(state.b, state.nb);
+        s = -from_limbs(state.m[2], state.nm[2]);
+    }
+    if (g == 0) {
+        s = 0;
+    } else if (b != 0) {
+        big_integer period = b / g;
+        s %= period;
+        if (s * 2 > period) {
+            s -= period;
+        } else if (s * 2 < -period) {
+            s += period;
+        }
+    }
+    return g;
+}
+
+std::tuple<big_integer, big_integer, big_integer> gcdext(big_integer const& a, big_integer const& b) {
+    big_integer abs_a = (a < 0 ? -a : a);
+    big_integer abs_b = (b < 0 ? -b : b);
+    big_integer s;
+    big_integer g = big_integer::gcd_cofactor(abs_a, abs_b, s);
+    if (a < 0) {
+        s = -s;
+    }
+    // b != 0 unless g = |a|, and then s * a = g
+    big_integer t = (b == 0 ? big_integer(0) : (g - s * a) / b);
+    return std::make_tuple(g, s, t);
+}
+
+big_integer invert(big_integer const& a, big_integer const& m) {
+    if (m == 0) {
+        throw std::runtime_error("oops, division by zero :(");
+    }
+    big_integer modulus = (m < 0 ? -m : m);
+    big_integer reduced = a % modulus;
+    if (reduced < 0) {
+        reduced += modulus;
+    }
+    big_integer s;
+    if (big_integer::gcd_cofactor(reduced, modulus, s) != 1) {
+        if (modulus == 1) {
+            return 0;
+        }
+        throw std::runtime_error("oops, the value is not invertible :(");
+    }
+    return (s < 0 ? s + modulus : s);
+}
+
+int big_integer::bit_length(big_integer const& a) {
+    limb storage;
+    int n;
+    limb const * value = limbs_of(a, storage, n);
+    return powering::bit_length(value, n);
+}
+
+// s = floor(sqrt(a)), r = a - s^2 for a >= 0, by Zimmermann's Karatsuba square root: with a shifted
+// so that its top quarter is normalized, a = a3 * B^3 + a2 * B^2 + a1 * B + a0 for B = 2^k, the root of
+// the top half gives the top half of s, one division by its double the bottom half
+void big_integer::sqrt_rem(big_integer const& a, big_integer& s, big_integer& r) {
+    int bits = bit_length(a);
+    if (bits <= LIMB_BITS) {
+        limb storage;
+        int n;
+        limb value = (bits == 0 ? 0 : *limbs_of(a, storage, n));
+        limb root = (limb)std::sqrt((double)value);
+        while ((dlimb)root * root > value) {
+            --root;
+        }
+        while ((dlimb)(root + 1) * (root + 1) <= value) {
+            ++root;
+        }
+        s = from_limbs(&root, 1);
+        r = a - s * s;
+        return;
+    }
+    int k = (bits + 3) / 4;
+    int c = (4 * k - bits) / 2;
+    big_integer x = a << (2 * c);
+    big_integer high = x >> (2 * k);
+    big_integer middle = x >> k;
+    big_integer a1 = middle - (high << k);
+    big_integer a0 = x - (middle << k);
+
+    big_integer s1, r1, q, u;
+    sqrt_rem(high, s1, r1);
+    divide((r1 << k) + a1, s1 << 1, &q, &u);
+    s = (s1 << k) + q;
+    r = (u << k) + a0 - q * q;
+    if (r < 0) {
+        r += (s << 1) - 1;
+        --s;
+    }
+    if (c > 0) {
+        s >>= c;
+        r = a - s * s;
+    }
+}
+
+// floor(a^(1 / n)) for a >= 1, n >= 2: the root of the top half of the bits, shifted back, overestimates
+// the root by a relative error of about 2^-h, and Newton's iteration from above then converges in a few steps
+big_integer big_integer::root(big_integer const& a, int n) {
+    int bits = bit_length(a);
+    if (bits <= n) {
+        return 1;
+    }
+    big_integer y;
+    if (bits <= 30 * n) {
+        // the root is below 2^30, the leading 64 bits in a double give it to within one
+        int shift = std::max(bits - 64, 0);
+        limb storage;
+        int length;
+        big_integer top = a >> shift;
+        limb const * value = limbs_of(top, storage, length);
+        double leading = 0;
+        for (int i = length - 1; i >= 0; --i) {
+            leading = std::ldexp(leading, LIMB_BITS) + (double)value[i];
+        }
+        y = big_integer((int)std::exp2((std::log2(leading) + shift) / n));
+        while (powering::pow(y, n) > a) {
+            --y;
+        }
+        while (powering::pow(y + 1, n) <= a) {
+            ++y;
+        }
+        return y;
+    }
+    int h = bits / (2 * n);
+    y = (root(a >> (n * h), n) + 1) << h;
+    while (true) {
+        big_integer z = (y * (n - 1) + a / powering::pow(y, n - 1)) / n;
+        if (z >= y) {
+            return y;
+        }
+        y.swap(z);
+    }
+}
+
+big_integer isqrt(big_integer const& a) {
+    if (a < 0) {
+        throw std::runtime_error("oops, square root of a negative number :(");
+    }
+    big_integer s, r;
+    big_integer::sqrt_rem(a, s, r);
+    return s;
+}
+
+big_integer iroot(big_integer const& a, int n) {
+    if (n <= 0) {
+        throw std::runtime_error("oops, root of a non-positive degree :(");
+    }
+    if (a < 0) {
+        if (n % 2 == 0) {
+            throw std::runtime_error("oops, even root of a negative number :(");
+        }
+        return -iroot(-a, n);
+    }
+    if (n == 1 || a <= 1) {
+        return a;
+    }
+    if (n == 2) {
+        return isqrt(a);
+    }
+    return big_integer::root(a, n);
+}
+
+namespace primality {
+    typedef big_integer::limb limb;
+
+    // the odd primes below TRIAL_LIMIT are tried as divisors, grouped so that the product of each group
+    // fits into a limb: one remainder pass over n per group, then only single-limb remainders
+    const int TRIAL_LIMIT = 1024;
+
+    // the primes up to n in increasing order, by an odd-only sieve of Eratosthenes
+    std::vector<int> primes_up_to(int n) {
+        std::vector<int> result;
+        if (n < 2) {
+            return result;
+        }
+        result.push_back(2);
+        std::vector<bool> composite(n / 2 + 1, false);
+        for (int p = 3; p <= n; p += 2) {
+            if (composite[p / 2]) {
+                continue;
+            }
+            result.push_back(p);
+            for (long long q = (long long)p * p; q <= n; q += 2 * p) {
+                composite[q / 2] = true;
+            }
+        }
+        return result;
+    }
+
+    struct prime_batch {
+        limb product;
+        std::vector<int> primes;
+    };
+
+    std::vector<prime_batch> make_batches() {
+        std::vector<int> primes = primes_up_to(TRIAL_LIMIT - 1);
+        std::vector<prime_batch> result;
+        for (size_t i = 1; i < primes.size(); ++i) {
+            int p = primes[i];
+            if (result.empty() || result.back().product > ~(limb)0 / (limb)p) {
+                result.push_back(prime_batch());
+                result.back().product = 1;
+            }
+            result.back().product *= (limb)p;
+            result.back().primes.push_back(p);
+        }
+        return result;
+    }
+
+    std::vector<prime_batch> const& batches() {
+        static std::vector<prime_batch> const result = make_batches();
+        return result;
+    }
+
+    // the Jacobi symbol (a / n) for an odd n = n[0, len) > 1, by reciprocity down to (n mod |a| / |a|)
+    int jacobi(int a, limb const * n, int len) {
+        int result = 1;
+        int n_mod_8 = (int)(n[0] & 7);
+        if (a < 0) {
+            a = -a;
+            if (n_mod_8 % 4 == 3) {
+                result = -result;
+            }
+        }
+        for (; a % 2 == 0; a /= 2) {
+            if (n_mod_8 == 3 || n_mod_8 == 5) {
+                result = -result;
+            }
+        }
+        if (a % 4 == 3 && n_mod_8 % 4 == 3) {
+            result = -result;
+        }
+        int x = (int)limbs::mod_1(n, len, (limb)a), y = a;
+        while (x != 0) {
+            for (; x % 2 == 0; x /= 2) {
+                if (y % 8 == 3 || y % 8 == 5) {
+                    result = -result;
+                }
+            }
+            std::swap(x, y);
+            if (x % 4 == 3 && y % 4 == 3) {
+                result = -result;
+            }
+            x %= y;
+        }
+        return (y == 1 ? result : 0);
+    }
+
+    // a + b, a - b and a / 2 modulo the odd n for 0 <= a, b < n; they commute with the Montgomery form
+    big_integer add(big_integer const& a, big_integer const& b, big_integer const& n) {
+        big_integer result = a + b;
+        if (result >= n) {
+            result -= n;
+        }
+        return result;
+    }
+
+    big_integer sub(big_integer const& a, big_integer const& b, big_integer const& n) {
+        big_integer result = a - b;
+        if (result < 0) {
+            result += n;
+        }
+        return result;
+    }
+
+    big_integer half(big_integer const& a, big_integer const& n) {
+        return ((a & 1) == 0 ? a : a + n) >> 1;
+    }
+
+    // the strong probable prime test to base b (in Montgomery form) for n - 1 = d * 2^s with d odd
+    bool strong_test(montgomery const& ctx, big_integer const& b, big_integer const& d, int s) {
+        big_integer one = ctx.to_montgomery(1);
+        big_integer minus_one = ctx.modulus() - one;
+        big_integer x = ctx.pow(b, d);
+        if (x == one || x == minus_one) {
+            return true;
+        }
+        for (int i = 1; i < s; ++i) {
+            x = ctx.sqr(x);
+            if (x == minus_one) {
+                return true;
+            }
+            if (x == one) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // the strong Lucas probable prime test with P = 1, Q = (1 - D) / 4 for n + 1 = k * 2^s with k odd:
+    // U_k and V_k by doubling, U_2j = U_j V_j, V_2j = V_j^2 - 2 Q^j, and the steps to j + 1
+    // U_j+1 = (U_j + V_j) / 2, V_j+1 = (D U_j + V_j) / 2, then V_k*2^r for r < s
+    bool strong_lucas_test(montgomery const& ctx, int D, limb const * k, int nk, int s) {
+        big_integer const& n = ctx.modulus();
+        big_integer d = ctx.to_montgomery(D);
+        big_integer q = ctx.to_montgomery((1 - D) / 4);
+        big_integer u = ctx.to_montgomery(1), v = u, qj = q;
+        for (int i = powering::bit_length(k, nk) - 2; i >= 0; --i) {
+            u = ctx.mul(u, v);
+            v = sub(ctx.sqr(v), add(qj, qj, n), n);
+            qj = ctx.sqr(qj);
+            if (powering::bits_at(k, i, 1) != 0) {
+                big_integer next_u = half(add(u, v, n), n);
+                v = half(add(ctx.mul(d, u), v, n), n);
+                u = next_u;
+                qj = ctx.mul(qj, q);
+            }
+        }
+        if (u == 0 || v == 0) {
+            return true;
+        }
+        for (int r = 1; r < s; ++r) {
+            v = sub(ctx.sqr(v), add(qj, qj, n), n);
+            if (v == 0) {
+                return true;
+            }
+            qj = ctx.sqr(qj);
+        }
+        return false;
     }
-    inverse_all(elements, size, sign == -1);
-    make_correct();
-    check_sign();
-    return *this;
 }
 
-big_integer &big_integer::operator|=(const big_integer &rhs) {
-    if (capacity == 1 && rhs.capacity == 1) {
-        small |= rhs.small;
-        if (LEFT_BORDER <= small && small <= RIGHT_BORDER) {
-            return *this;
-        } else {
-            turn_big_mode();
-            return *this;
+bool is_probable_prime(big_integer const& n, int rounds) {
+    typedef big_integer::limb limb;
+    if (n < 2) {
+        return false;
+    }
+    if ((n & 1) == 0) {
+        return n == 2;
+    }
+    limb storage;
+    int len;
+    limb const * nl = big_integer::limbs_of(n, storage, len);
+    std::vector<primality::prime_batch> const& batches = primality::batches();
+    for (size_t i = 0; i < batches.size(); ++i) {
+        limb r = limbs::mod_1(nl, len, batches[i].product);
+        for (size_t j = 0; j < batches[i].primes.size(); ++j) {
+            if (r % (limb)batches[i].primes[j] == 0) {
+                return n == batches[i].primes[j];
+            }
         }
     }
-    if (capacity == 1) {
-        turn_big_mode();
+    if (n < primality::TRIAL_LIMIT * primality::TRIAL_LIMIT) {
+        return true;
     }
-    if (rhs.capacity == 1) {
-        copy_on_write();
-        big_integer::ll abs_taken = std::abs(rhs.small);
-        big_integer::ll first = (abs_taken % BASE), second = (abs_taken) / BASE;
-        if (rhs.small < 0LL) {
-            first ^= (BASE - 1LL);
-            second ^= (BASE - 1LL);
-        }
-        elements[0] |= first;
-        elements[1] |= second;
-        make_correct();
-        check_sign();
-        return *this;
+
+    montgomery ctx(n);
+    int s = 0;
+    big_integer d = n - 1;
+    for (; (d & 1) == 0; d >>= 1) {
+        ++s;
     }
-    if (size < rhs.size) {
-        ensure_capacity(rhs.size);
+    if (!primality::strong_test(ctx, ctx.to_montgomery(2), d, s)) {
+        return false;
     }
-    big_integer tmp = big_integer(rhs);
-    inverse_all(elements, size, sign == -1);
-    inverse_all(tmp.elements, tmp.size, tmp.sign == -1);
-    for (int i = 0; i < size; i++) {
-        uint x = elements[i], y = 0;
-        if (i < tmp.size) {
-            y = tmp.elements[i];
+
+    // Selfridge's choice: the first D in 5, -7, 9, -11, ... with (D / n) = -1; there is none for squares
+    int D = 5;
+    while (true) {
+        int j = primality::jacobi(D, nl, len);
+        if (j == -1) {
+            break;
+        }
+        if (j == 0) {
+            return false;
+        }
+        if (D == 17) {
+            big_integer root = isqrt(n);
+            if (root * root == n) {
+                return false;
+            }
+        }
+        D = (D > 0 ? -(D + 2) : -D + 2);
+    }
+    int t = 0;
+    big_integer k = n + 1;
+    for (; (k & 1) == 0; k >>= 1) {
+        ++t;
+    }
+    std::vector<limb> kl = big_integer::magnitude(k);
+    if (!primality::strong_lucas_test(ctx, D, &kl[0], (int)kl.size(), t)) {
+        return false;
+    }
+
+    // bases in [2, n - 2] from a xorshift generator seeded by n, so that the answer is reproducible
+    unsigned long long state = 0x9e3779b97f4a7c15ULL ^ nl[0];
+    int bits = big_integer::bit_length(n);
+    for (int round = 0; round < rounds; ++round) {
+        big_integer b = 0;
+        for (int i = 0; i < bits; i += 31) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            b = (b << 31) + (int)(state & 0x7fffffff);
+        }
+        b = b % (n - 3) + 2;
+        if (!primality::strong_test(ctx, ctx.to_montgomery(b), d, s)) {
+            return false;
         }
-        elements[i] = (x | y);
     }
-    if (sign == -1 || tmp.sign == -1) {
-        sign = -1;
+    return true;
+}
+
+namespace combinatorics {
+    typedef big_integer::limb limb;
+
+    // appends f^e to the factors, multiplying into the last one while the product fits into a limb
+    void push_factor(std::vector<limb>& factors, limb f, int e) {
+        for (; e > 0; --e) {
+            if (factors.empty() || factors.back() > ~(limb)0 / f) {
+                factors.push_back(f);
+            } else {
+                factors.back() *= f;
+            }
+        }
+    }
+
+    // the exponent of p in the prime swing n! / (n / 2)!^2: the number of odd floor(n / p^i), i >= 1
+    int swing_exponent(int n, int p) {
+        int e = 0;
+        for (int q = n / p; q > 0; q /= p) {
+            e += q & 1;
+        }
+        return e;
+    }
+
+    // the exponent of p in C(n, k) for 0 <= k <= n: the number of borrows of n - k in base p
+    int binomial_exponent(int n, int k, int p) {
+        int e = 0;
+        for (int a = n / p, b = k / p, c = (n - k) / p; a > 0; a /= p, b /= p, c /= p) {
+            e += a - b - c;
+        }
+        return e;
     }
-    inverse_all(elements, size, sign == -1);
-    make_correct();
-    check_sign();
-    return *this;
 }
 
-big_integer &big_integer::operator^=(big_integer const &rhs) {
-    if (capacity == 1 && rhs.capacity == 1) {
-        small ^= rhs.small;
-        if (LEFT_BORDER <= small && small <= RIGHT_BORDER) {
-            return *this;
-        } else {
-            turn_big_mode();
-            return *this;
+// the product of factors[0, n) by a balanced tree, so that the large products are of equal-sized operands
+big_integer big_integer::tree_product(limb const * factors, int n) {
+    if (n == 0) {
+        return 1;
+    }
+    if (n == 1) {
+        return from_limbs(factors, 1);
+    }
+    return tree_product(factors, n / 2) * tree_product(factors + n / 2, n - n / 2);
+}
+
+// the odd part of n!, (n / 2)!^2 times the odd part of the prime swing; primes holds the primes up to n
+big_integer big_integer::odd_factorial(int n, std::vector<int> const& primes) {
+    if (n < 3) {
+        return 1;
+    }
+    big_integer result = odd_factorial(n / 2, primes);
+    result *= result;
+    std::vector<limb> factors;
+    for (size_t i = 1; i < primes.size() && primes[i] <= n; ++i) {
+        combinatorics::push_factor(factors, (limb)primes[i], combinatorics::swing_exponent(n, primes[i]));
+    }
+    if (!factors.empty()) {
+        result *= tree_product(&factors[0], (int)factors.size());
+    }
+    return result;
+}
+
+big_integer factorial(int n) {
+    if (n < 0) {
+        throw std::runtime_error("oops, factorial of a negative number :(");
+    }
+    int twos = n;
+    for (int m = n; m != 0; m &= m - 1) {
+        --twos;
+    }
+    return big_integer::odd_factorial(n, primality::primes_up_to(n)) << twos;
+}
+
+big_integer binomial(int n, int k) {
+    typedef big_integer::limb limb;
+    if (n < 0) {
+        if (k < 0) {
+            return 0;
+        }
+        // C(n, k) = (-1)^k C(k - n - 1, k)
+        if ((long long)k - n - 1 > std::numeric_limits<int>::max()) {
+            throw std::runtime_error("oops, binomial coefficient is too large :(");
         }
+        big_integer result = binomial(k - n - 1, k);
+        return (k % 2 == 0 ? result : -result);
     }
-    if (capacity == 1) {
-        turn_big_mode();
+    if (k < 0 || k > n) {
+        return 0;
     }
-    if (rhs.capacity == 1) {
-        copy_on_write();
-        big_integer::ll abs_taken = std::abs(rhs.small);
-        big_integer::ll first = (abs_taken % BASE), second = (abs_taken) / BASE;
-        if (rhs.small < 0LL) {
-            first ^= (BASE - 1LL);
-            second ^= (BASE - 1LL);
-        }
-        elements[0] ^= first;
-        elements[1] ^= second;
-        make_correct();
-        check_sign();
+    k = std::min(k, n - k);
+    std::vector<limb> factors;
+    if (n / 32 > k) {
+        // sieving up to n would cost more than n (n - 1) ... (n - k + 1) / k!
+        for (int i = n - k + 1; i <= n; ++i) {
+            combinatorics::push_factor(factors, (limb)i, 1);
+        }
+        return (factors.empty() ? big_integer(1) : big_integer::tree_product(&factors[0], (int)factors.size()))
+                / factorial(k);
+    }
+    std::vector<int> primes = primality::primes_up_to(n);
+    for (size_t i = 0; i < primes.size(); ++i) {
+        combinatorics::push_factor(factors, (limb)primes[i], combinatorics::binomial_exponent(n, k, primes[i]));
+    }
+    return (factors.empty() ? big_integer(1) : big_integer::tree_product(&factors[0], (int)factors.size()));
+}
+
+big_integer primorial(int n) {
+    typedef big_integer::limb limb;
+    std::vector<int> primes = primality::primes_up_to(n);
+    std::vector<limb> factors;
+    for (size_t i = 0; i < primes.size(); ++i) {
+        combinatorics::push_factor(factors, (limb)primes[i], 1);
+    }
+    return (factors.empty() ? big_integer(1) : big_integer::tree_product(&factors[0], (int)factors.size()));
+}
+
+// the product of values[first, last) by a tree that splits the factors into halves of equal total length,
+// prefix[i] being the length of values[0, i); while threads > 1, the left subtree goes to another thread,
+// which only reads the values through operator*= and so never touches the reference counts of their limbs
+void big_integer::product_tree(big_integer const * values, long long const * prefix, int first, int last,
+                               int threads, big_integer * result) {
+    long long total = prefix[last] - prefix[first];
+    if (last - first <= 2 || total <= karatsuba_threshold) {
+        big_integer accumulator = 1;
+        for (int i = first; i < last; ++i) {
+            accumulator *= values[i];
+        }
+        result->swap(accumulator);
+        return;
+    }
+    int mid = (int)(std::lower_bound(prefix + first + 1, prefix + last, prefix[first] + (total + 1) / 2) - prefix);
+    mid = std::max(first + 1, std::min(mid, last - 1));
+    big_integer left, right;
+    if (threads > 1 && total >= parallel_product_threshold) {
+        std::thread worker(&big_integer::product_tree, values, prefix, first, mid, threads / 2, &left);
+        product_tree(values, prefix, mid, last, threads - threads / 2, &right);
+        worker.join();
+    } else {
+        product_tree(values, prefix, first, mid, 1, &left);
+        product_tree(values, prefix, mid, last, 1, &right);
+    }
+    left *= right;
+    result->swap(left);
+}
+
+big_integer product(std::vector<big_integer> const& values, int threads) {
+    std::vector<long long> prefix(values.size() + 1, 0);
+    for (size_t i = 0; i < values.size(); ++i) {
+        prefix[i + 1] = prefix[i] + std::max(big_integer::length(values[i]), 1);
+    }
+    big_integer result = 1;
+    if (!values.empty()) {
+        big_integer::product_tree(&values[0], &prefix[0], 0, (int)values.size(), std::max(threads, 1), &result);
+    }
+    return result;
+}
+
+big_integer &big_integer::operator<<=(int rhs) {
+    if (rhs < 0) {
+        shift_right(-rhs);
+    } else {
+        shift_left(rhs);
+    }
+    return *this;
+}
+
+big_integer &big_integer::operator>>=(int rhs) {
+    if (rhs < 0) {
+        shift_left(-rhs);
+    } else {
+        shift_right(rhs);
+    }
+    return *this;
+}
+
+big_integer &big_integer::operator%=(big_integer const &rhs) {
+    if (capacity == 1 && rhs.capacity == 1 && rhs.small != 0) {
+        small %= rhs.small;
         return *this;
     }
-    if (size < rhs.size) {
-        ensure_capacity(rhs.size);
+    big_integer remainder;
+    divide(*this, rhs, 0, &remainder);
+    swap(remainder);
+    return *this;
+}
+
+namespace bitwise {
+    big_integer::limb bit_and(big_integer::limb a, big_integer::limb b) {
+        return a & b;
+    }
+    big_integer::limb bit_or(big_integer::limb a, big_integer::limb b) {
+        return a | b;
     }
-    big_integer tmp = big_integer(rhs);
-    inverse_all(elements, size, sign == -1);
-    inverse_all(tmp.elements, tmp.size, tmp.sign == -1);
-    for (int i = 0; i < size; i++) {
-        uint x = elements[i], y = 0;
-        if (i < tmp.size) {
-            y = tmp.elements[i];
+    big_integer::limb bit_xor(big_integer::limb a, big_integer::limb b) {
+        return a ^ b;
+    }
+}
+
+// dst[0, n) = *this in two's complement, n must leave room for the sign bit
+void big_integer::to_twos_complement(limb * dst, int n) const {
+    if (capacity == 1) {
+        dst[0] = (limb)small;
+        for (int i = 1; i < n; ++i) {
+            dst[i] = (small < 0 ? ~(limb)0 : 0);
+        }
+        return;
+    }
+    assert(size < n);
+    for (int i = 0; i < n; ++i) {
+        dst[i] = (i < size ? elements[i] : 0);
+    }
+    if (sign < 0) {
+        limb carry = 1;
+        for (int i = 0; i < n; ++i) {
+            dst[i] = ~dst[i] + carry;
+            carry = (carry != 0 && dst[i] == 0 ? 1 : 0);
         }
-        elements[i] = (x ^ y);
     }
-    if (sign != tmp.sign) {
-        sign = -1;
+}
+
+// *this = src[0, n) read as a two's complement number
+void big_integer::assign_twos_complement(limb const * src, int n) {
+    bool negative = (src[n - 1] >> (LIMB_BITS - 1)) != 0;
+    limb * tmp = ui::alloc(n + 1, 1);
+    limb carry = 1;
+    for (int i = 0; i < n; ++i) {
+        if (negative) {
+            tmp[i] = ~src[i] + carry;
+            carry = (carry != 0 && tmp[i] == 0 ? 1 : 0);
+        } else {
+            tmp[i] = src[i];
+        }
     }
-    inverse_all(elements, size, sign == -1);
+    tmp[n] = 0;
+    if (capacity != 1) {
+        ui::release(elements);
+    }
+    elements = tmp;
+    capacity = n + 1;
+    size = n;
+    sign = (negative ? -1 : 1);
     make_correct();
     check_sign();
+}
+
+// *this = op(*this, rhs) limb by limb over the two's complement representations
+big_integer &big_integer::apply_bitwise(big_integer const &rhs, limb (*op)(limb, limb)) {
+    int n = std::max(capacity == 1 ? 1 : size, rhs.capacity == 1 ? 1 : rhs.size) + 1;
+    limb * a = ui::alloc(2 * n, 1);
+    limb * b = a + n;
+    to_twos_complement(a, n);
+    rhs.to_twos_complement(b, n);
+    for (int i = 0; i < n; ++i) {
+        a[i] = op(a[i], b[i]);
+    }
+    assign_twos_complement(a, n);
+    ui::release(a);
     return *this;
 }
 
+big_integer &big_integer::operator&=(big_integer const &rhs) {
+    if (capacity == 1 && rhs.capacity == 1) {
+        small &= rhs.small;
+        return *this;
+    }
+    return apply_bitwise(rhs, bitwise::bit_and);
+}
+
+big_integer &big_integer::operator|=(big_integer const &rhs) {
+    if (capacity == 1 && rhs.capacity == 1) {
+        small |= rhs.small;
+        return *this;
+    }
+    return apply_bitwise(rhs, bitwise::bit_or);
+}
+
+big_integer &big_integer::operator^=(big_integer const &rhs) {
+    if (capacity == 1 && rhs.capacity == 1) {
+        small ^= rhs.small;
+        return *this;
+    }
+    return apply_bitwise(rhs, bitwise::bit_xor);
+}
+
 void big_integer::turn_big_mode() {
     big_integer::ll saved_small = small;
     elements = ui::alloc(3, 1);
@@ -1030,8 +3581,10 @@ void big_integer::turn_big_mode() {
     } else {
         sign = 1;
     }
-    elements[0] = (uint)(saved_small % BASE);
-    elements[1] = (uint)(saved_small / BASE);
+    // |small| < 2^63, the second shift is split to stay defined for 64-bit limbs
+    unsigned long long magnitude = (unsigned long long)saved_small;
+    elements[0] = (limb)magnitude;
+    elements[1] = (limb)((magnitude >> (LIMB_BITS / 2)) >> (LIMB_BITS / 2));
     elements[2] = 0;
     size = 2;
     if (elements[1] == 0) {
@@ -1045,7 +3598,7 @@ void big_integer::copy_on_write() {
         return;
     }
     if (elements[-1] == 1) return;
-    uint *tmp = ui::alloc(capacity, 1);
+    limb *tmp = ui::alloc(capacity, 1);
     for (int i = 0; i < capacity; ++i) {
         if (i < size) {
             tmp[i] = elements[i];
@@ -1062,15 +3615,17 @@ big_integer &big_integer::mul_small(big_integer::ll value) {
         sign *= -1;
         value = std::abs(value);
     }
-    big_integer::ll carry = 0LL;
+    limb carry = 0;
     for (int i = 0; i < size; i++) {
-        big_integer::ll cur = 1LL * elements[i] * value + carry;
-        elements[i] = (uint)(cur % BASE);
-        carry = cur / BASE;
+        dlimb cur = (dlimb)elements[i] * (limb)value + carry;
+        elements[i] = (limb)cur;
+        carry = (limb)(cur >> LIMB_BITS);
     }
     if (carry > 0) {
-        elements[size++] = (uint)carry;
+        elements[size++] = carry;
     }
+    make_correct();
+    check_sign();
     return *this;
 }
 
@@ -1079,12 +3634,7 @@ big_integer &big_integer::div_small(big_integer::ll value) {
         sign *= -1;
         value = std::abs(value);
     }
-    big_integer::ll carry = 0LL;
-    for (int i = size - 1; i >= 0; --i) {
-        big_integer::ll cur = 1LL * elements[i] + carry * big_integer::BASE;
-        elements[i] = (uint)(cur / value);
-        carry = cur % value;
-    }
+    limbs::divrem_small(elements, elements, size, (limb)value);
     make_correct();
     check_sign();
     return *this;
@@ -1133,3 +3683,279 @@ big_integer operator^(big_integer a, big_integer const& b) {
     a ^= b;
     return a;
 }
+
+to_chars_result to_chars(char * first, char * last, big_integer const& a, int base) {
+    typedef big_integer::limb limb;
+    if (base < 2 || base > 36) {
+        throw std::runtime_error("oops, radix out of range :(");
+    }
+    to_chars_result too_large = {last, std::errc::value_too_large};
+    size_t negative = (a < 0 ? 1 : 0);
+    int bits = conversion::power_of_two_bits(base);
+    if (bits != 0) {
+        size_t count = big_integer::bit_digits(a, bits);
+        if ((size_t)(last - first) < negative + count) {
+            return too_large;
+        }
+        if (negative) {
+            *first++ = '-';
+        }
+        big_integer::write_bits(a, bits, first);
+        to_chars_result result = {first + count, std::errc()};
+        return result;
+    }
+    limb storage;
+    int n;
+    limb const * value = big_integer::limbs_of(a, storage, n);
+    std::string text;
+    char buffer[conversion::STACK_LIMBS * big_integer::LIMB_BITS];
+    char const * digits;
+    size_t count;
+    if (n <= conversion::STACK_LIMBS) {
+        limb tmp[conversion::STACK_LIMBS];
+        std::copy(value, value + n, tmp);
+        count = big_integer::write_chunks(tmp, n, base, buffer + sizeof(buffer));
+        digits = buffer + sizeof(buffer) - count;
+    } else {
+        text = to_string(a, base);
+        count = text.size() - negative;
+        digits = text.data() + negative;
+    }
+    if ((size_t)(last - first) < negative + count) {
+        return too_large;
+    }
+    if (negative) {
+        *first++ = '-';
+    }
+    to_chars_result result = {std::copy(digits, digits + count, first), std::errc()};
+    return result;
+}
+
+from_chars_result from_chars(char const * first, char const * last, big_integer& a, int base) {
+    typedef big_integer::limb limb;
+    if (base < 2 || base > 36) {
+        throw std::runtime_error("oops, radix out of range :(");
+    }
+    char const * digits = first;
+    bool negative = (digits != last && *digits == '-');
+    if (negative) {
+        ++digits;
+    }
+    char const * end = digits;
+    while (end != last && conversion::digit_value(*end) < base) {
+        ++end;
+    }
+    if (end == digits) {
+        from_chars_result result = {first, std::errc::invalid_argument};
+        return result;
+    }
+    while (digits + 1 != end && *digits == '0') {
+        ++digits;
+    }
+    size_t n = (size_t)(end - digits);
+    limb chunk_base;
+    if (n <= (size_t)conversion::chunk_digits(base, chunk_base)) {
+        // a single limb, inline for small values
+        limb x = 0;
+        for (char const * p = digits; p != end; ++p) {
+            x = x * base + (limb)conversion::digit_value(*p);
+        }
+        if (x <= (limb)big_integer::RIGHT_BORDER + (negative ? 1 : 0)) {
+            a = (int)(negative ? -(long long)x : (long long)x);
+        } else {
+            a = big_integer::from_limbs(&x, 1);
+            if (negative) {
+                a = -a;
+            }
+        }
+    } else {
+        int bits = conversion::power_of_two_bits(base);
+        big_integer value = (bits != 0 ? big_integer::parse_bits(digits, n, bits)
+                                       : big_integer::parse_digits(digits, n, base));
+        if (negative) {
+            value = -value;
+        }
+        a.swap(value);
+    }
+    from_chars_result result = {end, std::errc()};
+    return result;
+}
+
+size_t to_chars_length(big_integer const& a, int base) {
+    typedef big_integer::limb limb;
+    if (base < 2 || base > 36) {
+        throw std::runtime_error("oops, radix out of range :(");
+    }
+    size_t negative = (a < 0 ? 1 : 0);
+    int bits = conversion::power_of_two_bits(base);
+    if (bits != 0) {
+        return negative + big_integer::bit_digits(a, bits);
+    }
+    limb storage;
+    int n;
+    limb const * value = big_integer::limbs_of(a, storage, n);
+    if (n <= conversion::STACK_LIMBS) {
+        limb tmp[conversion::STACK_LIMBS];
+        char buffer[conversion::STACK_LIMBS * big_integer::LIMB_BITS];
+        std::copy(value, value + n, tmp);
+        return negative + big_integer::write_chunks(tmp, n, base, buffer + sizeof(buffer));
+    }
+    // |a| >= 2^(bits - 1) has at least (bits - 1) log_base(2) + 1 digits, the slack covers the rounding
+    int length = big_integer::bit_length(a);
+    int digits = (int)((length - 1) / std::log2((double)base) * 0.999999) + 1;
+    big_integer magnitude = (negative ? -a : a);
+    big_integer power = powering::pow(base, digits);
+    while (magnitude >= power) {
+        power *= base;
+        ++digits;
+    }
+    return negative + (size_t)digits;
+}
+
+big_integer_parser::big_integer_parser(int radix) : radix(radix), block_level(0), started(false),
+        digits_seen(false), negative(false), leading_zero(false), chunk(0), chunk_length(0), block(1, 0),
+        block_chunks(0) {
+    if (radix < 2 || radix > 36) {
+        throw std::runtime_error("oops, radix out of range :(");
+    }
+    chunk_digits = conversion::chunk_digits(radix, chunk_base);
+    // blocks of about decimal_threshold limbs, short enough for the multiply-add passes
+    while ((2 << block_level) <= big_integer::decimal_threshold) {
+        ++block_level;
+    }
+}
+
+char const * big_integer_parser::feed(char const * first, char const * last) {
+    for (; first != last; ++first) {
+        if (!started && (*first == '-' || *first == '+')) {
+            started = true;
+            negative = (*first == '-');
+            continue;
+        }
+        if (leading_zero && (*first == 'x' || *first == 'X')) {
+            leading_zero = false;
+            continue;
+        }
+        int digit = conversion::digit_value(*first);
+        if (digit >= radix) {
+            return first;
+        }
+        leading_zero = (radix == 16 && !digits_seen && digit == 0);
+        started = digits_seen = true;
+        chunk = chunk * radix + (limb)digit;
+        if (++chunk_length < chunk_digits) {
+            continue;
+        }
+        for (size_t i = 0; i < block.size(); ++i) {
+            big_integer::dlimb cur = (big_integer::dlimb)block[i] * chunk_base + chunk;
+            block[i] = (limb)cur;
+            chunk = (limb)(cur >> big_integer::LIMB_BITS);
+        }
+        if (chunk != 0) {
+            block.push_back(chunk);
+        }
+        chunk = 0;
+        chunk_length = 0;
+        if (++block_chunks == (1 << block_level)) {
+            push_block();
+        }
+    }
+    return last;
+}
+
+// moves the full block to the counter, merging the two least significant values while they are equal in length
+void big_integer_parser::push_block() {
+    values.push_back(big_integer::from_limbs(&block[0], (int)block.size()));
+    levels.push_back(block_level);
+    block.assign(1, 0);
+    block_chunks = 0;
+    size_t n = values.size();
+    while (n >= 2 && levels[n - 2] == levels[n - 1]) {
+        int level = levels[n - 1];
+        if ((int)powers.size() <= level) {
+            powers = big_integer::radix_powers(radix, level);
+        }
+        values[n - 2] *= powers[level];
+        values[n - 2] += values[n - 1];
+        ++levels[n - 2];
+        values.pop_back();
+        levels.pop_back();
+        --n;
+    }
+}
+
+bool big_integer_parser::has_digits() const {
+    return digits_seen;
+}
+
+big_integer big_integer_parser::value() const {
+    big_integer result = 0;
+    if (!values.empty()) {
+        std::vector<big_integer> p = big_integer::radix_powers(radix, levels[0]);
+        result = values[0];
+        for (size_t i = 1; i < values.size(); ++i) {
+            result *= p[levels[i]];
+            result += values[i];
+        }
+    }
+    // the partial block and the partial chunk
+    int tail_digits = block_chunks * chunk_digits + chunk_length;
+    if (tail_digits != 0) {
+        big_integer tail = big_integer::from_limbs(&block[0], (int)block.size());
+        tail *= powering::pow(radix, chunk_length);
+        tail += big_integer::from_limbs(&chunk, 1);
+        result *= powering::pow(radix, tail_digits);
+        result += tail;
+    }
+    return (negative ? -result : result);
+}
+
+std::istream& operator>>(std::istream& in, big_integer& a) {
+    std::istream::sentry sentry(in);
+    if (!sentry) {
+        return in;
+    }
+    std::ios_base::fmtflags basefield = in.flags() & std::ios_base::basefield;
+    big_integer_parser parser(basefield == std::ios_base::hex ? 16 : basefield == std::ios_base::oct ? 8 : 10);
+    std::streambuf * buffer = in.rdbuf();
+    std::ios_base::iostate state = std::ios_base::goodbit;
+    // the characters waiting in the get area are taken in spans, short ones first since most numbers are,
+    // and the part of a span behind the number is put back, it is still in the get area
+    char text[1024];
+    std::streamsize span = 16;
+    while (true) {
+        if (buffer->sgetc() == std::char_traits<char>::eof()) {
+            state |= std::ios_base::eofbit;
+            break;
+        }
+        std::streamsize available = std::min(buffer->in_avail(), span);
+        if (available <= 0) {
+            // no get area: the character is only peeked, so that nothing has to be put back
+            char ch = (char)buffer->sgetc();
+            if (parser.feed(&ch, &ch + 1) == &ch) {
+                break;
+            }
+            buffer->sbumpc();
+            continue;
+        }
+        std::streamsize n = buffer->sgetn(text, available);
+        char const * end = parser.feed(text, text + n);
+        if (end != text + n) {
+            for (char const * p = text + n; p != end; ) {
+                if (buffer->sputbackc(*--p) == std::char_traits<char>::eof()) {
+                    state |= std::ios_base::badbit;
+                    break;
+                }
+            }
+            break;
+        }
+        span = std::min(span * 2, (std::streamsize)sizeof(text));
+    }
+    if (parser.has_digits()) {
+        a = parser.value();
+    } else {
+        state |= std::ios_base::failbit;
+    }
+    in.setstate(state);
+    return in;
+}
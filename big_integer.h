@@ -10,6 +10,22 @@
 #define BIG_INTEGER_H
 
 #include <vector>
+#include <utility>
+#include <tuple>
+#include <system_error>
+
+// the results of to_chars and from_chars, as std::to_chars_result and std::from_chars_result
+struct to_chars_result
+{
+    char * ptr;
+    std::errc ec;
+};
+
+struct from_chars_result
+{
+    char const * ptr;
+    std::errc ec;
+};
 
 struct big_integer
 {
@@ -18,14 +34,46 @@ public:
     typedef long long ll;
     typedef unsigned int uint;
     
+    // limbs of the magnitude are full machine words, dlimb holds the product of two of them;
+    // define BIG_INTEGER_32BIT_LIMBS (or build without __int128) for 32-bit limbs
+#if defined(__SIZEOF_INT128__) && !defined(BIG_INTEGER_32BIT_LIMBS)
+    typedef unsigned long long limb;
+    __extension__ typedef unsigned __int128 dlimb;
+#else
+    typedef unsigned int limb;
+    typedef unsigned long long dlimb;
+#endif
+    static const int LIMB_BITS = 8 * (int)sizeof(limb);
+    
+    // values in [LEFT_BORDER, RIGHT_BORDER] are kept inline, without allocating limbs
     static const ll BASE = (1LL << 31LL);
     static const ll LEFT_BORDER = -BASE;
     static const ll RIGHT_BORDER = BASE - 1LL;
     
+    // operand sizes (in limbs) from which operator*= switches to the next multiplication tier
+    static int karatsuba_threshold;
+    static int toom3_threshold;
+    static int toom4_threshold;
+    static int ntt_threshold;
+    // divisor sizes (in limbs) from which operator/= switches to recursive division and
+    // to multiplication by a Newton reciprocal
+    static int burnikel_ziegler_threshold;
+    static int newton_threshold;
+    // operand size (in limbs) from which gcd reduces the numbers by the half-gcd recursion
+    // instead of Lehmer steps
+    static int half_gcd_threshold;
+    // number length (in limbs) from which to_string and the string constructors split the digits by
+    // powers of the radix, for radices other than powers of two
+    static int decimal_threshold;
+    // total length (in limbs) of the factors from which product hands a subtree to another thread
+    static int parallel_product_threshold;
+    
     big_integer(); // done
     big_integer(big_integer const& other); // done
     big_integer(int a); // done
     explicit big_integer(std::string const& str); // done
+    // digits 0-9 and then a-z or A-Z in a radix from 2 to 36, with an optional leading '-'
+    big_integer(std::string const& str, int radix); // done
     ~big_integer(); // done
     
     big_integer& operator=(big_integer const& other); // done
@@ -61,12 +109,50 @@ public:
     friend bool operator>=(big_integer const& a, big_integer const& b); // done
     
     friend std::string to_string(big_integer const& a); // done
+    // lower case digits in a radix from 2 to 36, powers of two in a single pass over the limbs
+    friend std::string to_string(big_integer const& a, int radix); // done
+    // std::to_chars and std::from_chars in a base from 2 to 36: to_chars writes no terminating zero and
+    // fails with value_too_large if the buffer is short; from_chars reads an optional '-' and the longest
+    // run of digits, or fails with invalid_argument if there are none and leaves a unchanged.
+    // Neither allocates for values that fit into an int, nor does to_chars up to a few hundred digits;
+    // to_chars_length is the exact number of characters to_chars writes
+    friend to_chars_result to_chars(char * first, char * last, big_integer const& a, int base); // done
+    friend from_chars_result from_chars(char const * first, char const * last, big_integer& a, int base); // done
+    friend size_t to_chars_length(big_integer const& a, int base); // done
+    
+    // quotient rounded towards zero and remainder with the sign of a, from a single division
+    friend std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b); // done
+    
+    // the greatest common divisor of |a| and |b|, gcd(0, 0) = 0
+    friend big_integer gcd(big_integer const& a, big_integer const& b); // done
+    // (g, s, t) with g = gcd(a, b) = s * a + t * b and |s| <= |b| / 2g; a^-1 mod |m| in [0, |m|)
+    friend std::tuple<big_integer, big_integer, big_integer> gcdext(big_integer const& a, big_integer const& b); // done
+    friend big_integer invert(big_integer const& a, big_integer const& m); // done
+    
+    // floor(sqrt(a)) for a >= 0; the n-th root of a rounded towards zero, n >= 1, a >= 0 unless n is odd
+    friend big_integer isqrt(big_integer const& a); // done
+    friend big_integer iroot(big_integer const& a, int n); // done
+    // false for composites and n < 2; true for primes and, in principle, for Baillie-PSW pseudoprimes,
+    // none of which is known; rounds adds that many Miller-Rabin tests with pseudo-random bases
+    friend bool is_probable_prime(big_integer const& n, int rounds); // done
+    // n! for n >= 0; C(n, k), zero for k < 0 and for k > n >= 0; the product of the primes up to n
+    friend big_integer factorial(int n); // done
+    friend big_integer binomial(int n, int k); // done
+    friend big_integer primorial(int n); // done
+    // the product of values, 1 if there are none, by a size-balanced tree of multiplications
+    // on up to threads threads
+    friend big_integer product(std::vector<big_integer> const& values, int threads); // done
     
     // a < b : -1; a > b: +1, a == b: 0
     friend int compare_absolute_value(big_integer const& a, big_integer const& b); // done
     friend int compare(big_integer const& a, big_integer const& b); // done
     
 private:
+    friend struct big_divisor;
+    friend struct montgomery;
+    friend struct barrett;
+    friend struct big_integer_parser;
+    
     void copy_on_write(); // done
     void turn_big_mode(); // done
     void resize(int new_size); // done
@@ -84,14 +170,205 @@ private:
     big_integer& mul_small(big_integer::ll value); // done
     big_integer& div_small(big_integer::ll value); // done
     
+    void to_twos_complement(limb * dst, int n) const; // done
+    void assign_twos_complement(limb const * src, int n); // done
+    big_integer& apply_bitwise(big_integer const& rhs, limb (*op)(limb, limb)); // done
+    
+    static big_integer from_limbs(limb const * src, int n); // done
+    static limb const * limbs_of(big_integer const& a, limb & storage, int & n); // done
+    static std::vector<limb> magnitude(big_integer const& a); // done
+    static void add_shifted(limb * r, int nr, big_integer const& x); // done
+    static void mul_limbs(limb * r, limb const * a, int na, limb const * b, int nb); // done
+    static void mul_balanced(limb * r, limb const * a, limb const * b, int n); // done
+    static void mul_toom(limb * r, limb const * a, limb const * b, int n, int k); // done
+    static void div_limbs(limb * q, limb * u, int nu, limb const * d, int nd); // done
+    static limb div_recursive(limb * q, limb * u, limb const * d, int n, limb * scratch); // done
+    static big_integer reciprocal(limb const * d, int n); // done
+    static void div_newton(limb * q, limb * u, int nu, limb const * d, int nd, big_integer& inverse); // done
+    static void div_newton(limb * q, limb * u, int nu, limb const * d, int nd, big_integer const& inverse); // done
+    static void divide(big_integer const& a, big_integer const& b, big_integer * q, big_integer * r); // done
+    static void store_division(limb * quotient, int qn, limb * u, int nd, int shift, bool negative_quotient,
+                               bool negative_remainder, big_integer * q, big_integer * r); // done
+    
+    struct reduction;
+    static int length(big_integer const& a); // done
+    static int combine(limb * r, limb const * x, int nx, limb u, limb const * y, int ny, limb v, bool subtract); // done
+    static void add_product(reduction& state, limb * r, int & nr, limb const * x, int nx, limb const * y, int ny); // done
+    static bool lehmer_step(reduction& state, int s); // done
+    static bool subdiv_step(reduction& state, int s); // done
+    static bool hgcd(reduction& state); // done
+    static bool hgcd_reduce(reduction& state, int p, int s); // done
+    static void euclid(reduction& state); // done
+    static big_integer gcd_cofactor(big_integer const& a, big_integer const& b, big_integer& s); // done
+    
+    static int bit_length(big_integer const& a); // done
+    static void sqrt_rem(big_integer const& a, big_integer& s, big_integer& r); // done
+    static big_integer root(big_integer const& a, int n); // done
+
+    static big_integer tree_product(limb const * factors, int n); // done
+    static big_integer odd_factorial(int n, std::vector<int> const& primes); // done
+    static void product_tree(big_integer const * values, long long const * prefix, int first, int last,
+                             int threads, big_integer * result); // done
+
+    static size_t write_chunks(limb * tmp, int n, int radix, char * end); // done
+    static void write_chunks(big_integer const& a, int radix, size_t pad, std::string& out); // done
+    static std::vector<big_integer> radix_powers(int radix, int k); // done
+    static void write_digits(big_integer const& a, int radix, int k, bool pad,
+                             std::vector<big_integer> const& powers, std::string& out); // done
+    static size_t bit_digits(big_integer const& a, int bits); // done
+    static void write_bits(big_integer const& a, int bits, char * out); // done
+    static big_integer parse_digits(char const * digits, size_t n, int radix); // done
+    static big_integer parse_digits(char const * digits, size_t n, int radix, int k,
+                                    std::vector<big_integer> const& powers); // done
+    static big_integer parse_bits(char const * digits, size_t n, int bits); // done
+    
     int size, capacity;
     union {
-        uint *elements;
+        limb *elements;
         long long small;
     };
     int sign;
+};
+
+// a divisor prepared once for dividing many values by it: the divisor is normalized up front and
+// its reciprocal is precomputed (a single-limb inverse, or floor(B^2n / d) for long divisors)
+struct big_divisor
+{
+public:
+    // divisor sizes (in limbs) from which the quotient is found by multiplying with the reciprocal
+    static int reciprocal_threshold;
+    
+    explicit big_divisor(big_integer const& d); // done
+    
+    big_integer const& value() const; // done
     
-    static const int POWER = 31;
+    // the same results as a / d, a % d and divmod(a, d)
+    big_integer div(big_integer const& a) const; // done
+    big_integer mod(big_integer const& a) const; // done
+    std::pair<big_integer, big_integer> divmod(big_integer const& a) const; // done
+    
+private:
+    typedef big_integer::limb limb;
+    
+    void divide(big_integer const& a, big_integer * q, big_integer * r) const; // done
+    
+    big_integer divisor;
+    std::vector<limb> normalized;
+    int shift;
+    limb inverse_1;
+    big_integer inverse;
+};
+
+// arithmetic modulo a fixed odd m > 0 in Montgomery form, x * R mod m with R = B^n for an n-limb m:
+// a product is reduced by REDC, n multiply-add passes over the limbs, instead of a division
+struct montgomery
+{
+public:
+    explicit montgomery(big_integer const& m); // done
+    
+    big_integer const& modulus() const; // done
+    
+    // a * R mod m for any a; and back, a / R mod m for 0 <= a < m
+    big_integer to_montgomery(big_integer const& a) const; // done
+    big_integer from_montgomery(big_integer const& a) const; // done
+    
+    // a * b / R mod m for 0 <= a, b < m, the Montgomery form of the product
+    big_integer mul(big_integer const& a, big_integer const& b) const; // done
+    big_integer sqr(big_integer const& a) const; // done
+    
+    // a^e in Montgomery form for a in Montgomery form and e >= 0, by a sliding window over the bits of e
+    big_integer pow(big_integer const& a, big_integer const& e) const; // done
+    // the same with fixed windows, branch-free reductions and table lookups that read every entry:
+    // the operations and memory accesses depend only on the number of limbs of e, not on its bits
+    big_integer pow_sec(big_integer const& a, big_integer const& e) const; // done
+    
+private:
+    typedef big_integer::limb limb;
+    
+    void load(limb * dst, big_integer const& a) const; // done
+    void mul_n(limb * r, limb const * a, limb const * b, limb * scratch) const; // done
+    void sqr_n(limb * r, limb const * a, limb * scratch) const; // done
+    void mul_sec(limb * r, limb const * a, limb const * b, limb * scratch) const; // done
+    
+    big_integer m;
+    std::vector<limb> m_limbs;
+    int n;
+    limb m_inverse;
+    big_integer r2;
+};
+
+// reduction modulo a fixed m > 0 by Barrett's method: with mu = floor(B^2k / m) for a k-limb m, x mod m
+// for x < B^2k takes two multiplications and at most two subtractions instead of a division;
+// unlike montgomery it works for even moduli and on values in their usual form
+struct barrett
+{
+public:
+    explicit barrett(big_integer const& m); // done
+    
+    big_integer const& modulus() const; // done
+    
+    // x mod m in [0, m) for any x; longer values are reduced k limbs at a time
+    big_integer reduce(big_integer const& x) const; // done
+    
+    // a * b mod m, a^2 mod m and a^e mod m for 0 <= a, b < m and e >= 0
+    big_integer mul(big_integer const& a, big_integer const& b) const; // done
+    big_integer sqr(big_integer const& a) const; // done
+    big_integer pow(big_integer const& a, big_integer const& e) const; // done
+    
+private:
+    typedef big_integer::limb limb;
+    
+    int scratch_limbs() const; // done
+    void load(limb * dst, big_integer const& a) const; // done
+    void reduce_n(limb * r, limb const * x, limb * scratch) const; // done
+    void mul_n(limb * r, limb const * a, limb const * b, limb * scratch) const; // done
+    void sqr_n(limb * r, limb const * a, limb * scratch) const; // done
+    
+    big_integer m;
+    std::vector<limb> m_limbs;
+    std::vector<limb> mu;
+    int k;
+};
+
+// a number whose digits arrive in pieces, from a socket or a file, without keeping the text: digits are
+// folded into a block of limbs by a multiply-add per limb-sized chunk of digits, and full blocks are
+// combined pairwise like a binary counter, high * radix^(digits of low) + low, so that the total cost
+// stays that of the divide-and-conquer string constructor
+struct big_integer_parser
+{
+public:
+    explicit big_integer_parser(int radix = 10); // done
+    
+    // takes digits (0-9, then a-z or A-Z) from [first, last), and a '-' or '+' ahead of everything else;
+    // in radix 16 an x or X right after a leading 0 is skipped, so that 0x and 0X prefixes are read;
+    // returns the end of what was taken, which is last unless there is another character
+    char const * feed(char const * first, char const * last); // done
+    
+    bool has_digits() const; // done
+    // the value of the digits taken so far, 0 if there are none
+    big_integer value() const; // done
+    
+private:
+    typedef big_integer::limb limb;
+    
+    void push_block(); // done
+    
+    int radix;
+    int chunk_digits;
+    limb chunk_base;
+    // a full block holds chunk_digits << block_level digits
+    int block_level;
+    bool started, digits_seen, negative;
+    // the only digit so far is a 0, which may start a 0x prefix
+    bool leading_zero;
+    limb chunk;
+    int chunk_length;
+    std::vector<limb> block;
+    int block_chunks;
+    // the full blocks and their merges, most significant first, with chunk_digits << levels[i] digits each
+    std::vector<big_integer> values;
+    std::vector<int> levels;
+    std::vector<big_integer> powers;
 };
 
 big_integer operator+(big_integer a, big_integer const& b); // done
@@ -114,7 +391,37 @@ bool operator>(big_integer const& a, big_integer const& b); // done
 bool operator<=(big_integer const& a, big_integer const& b); // done
 bool operator>=(big_integer const& a, big_integer const& b); // done
 
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b); // done
+big_integer gcd(big_integer const& a, big_integer const& b); // done
+std::tuple<big_integer, big_integer, big_integer> gcdext(big_integer const& a, big_integer const& b); // done
+big_integer invert(big_integer const& a, big_integer const& m); // done
+big_integer isqrt(big_integer const& a); // done
+big_integer iroot(big_integer const& a, int n); // done
+bool is_probable_prime(big_integer const& n, int rounds = 0); // done
+big_integer factorial(int n); // done
+big_integer binomial(int n, int k); // done
+big_integer primorial(int n); // done
+big_integer product(std::vector<big_integer> const& values, int threads = 1); // done
+
+// the product of the values in [first, last), anything convertible to big_integer
+template <typename InputIterator>
+big_integer product(InputIterator first, InputIterator last, int threads = 1) {
+    return product(std::vector<big_integer>(first, last), threads);
+}
+// base^exp mod |mod|, in [0, |mod|), for exp >= 0; odd moduli are reduced in Montgomery form, even ones by Barrett's method
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod); // done
+// the same for an odd mod with montgomery::pow_sec, for secret exponents
+big_integer powmod_sec(big_integer const& base, big_integer const& exp, big_integer const& mod); // done
+
 std::string to_string(big_integer const& a); // done
+std::string to_string(big_integer const& a, int radix); // done
+to_chars_result to_chars(char * first, char * last, big_integer const& a, int base = 10); // done
+from_chars_result from_chars(char const * first, char const * last, big_integer& a, int base = 10); // done
+size_t to_chars_length(big_integer const& a, int base = 10); // done
 std::ostream& operator<<(std::ostream& s, big_integer const& a); // done
+// skips whitespace and reads an optional sign and the digits that follow, in hex (with an optional 0x prefix)
+// or oct as the stream's basefield says, through big_integer_parser; sets failbit and leaves a unchanged if
+// there are no digits
+std::istream& operator>>(std::istream& s, big_integer& a); // done
 
 #endif // BIG_INTEGER_H
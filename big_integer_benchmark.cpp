@@ -0,0 +1,57 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include "big_integer.h"
+
+namespace
+{
+    big_integer random_big_integer(size_t limbs)
+    {
+        big_integer result = 0;
+        for (size_t i = 0; i != limbs; ++i)
+        {
+            for (int bits = 0; bits < big_integer::LIMB_BITS; bits += 16)
+            {
+                result <<= 16;
+                result += rand() & 0xffff;
+            }
+        }
+        return result;
+    }
+
+    // microseconds per a * b
+    double time_mul(big_integer const& a, big_integer const& b, size_t repetitions)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i != repetitions; ++i)
+        {
+            big_integer c = a * b;
+        }
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / repetitions;
+    }
+}
+
+int main()
+{
+    size_t const sizes[] = {8, 64, 512};
+    int const saved_karatsuba = big_integer::karatsuba_threshold;
+
+    std::printf("%8s %16s %16s\n", "limbs", "schoolbook, us", "default, us");
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        big_integer a = random_big_integer(sizes[i]);
+        big_integer b = random_big_integer(sizes[i]);
+        size_t repetitions = 20000000 / (sizes[i] * sizes[i]) + 1;
+
+        big_integer::karatsuba_threshold = std::numeric_limits<int>::max();
+        double schoolbook = time_mul(a, b, repetitions);
+        big_integer::karatsuba_threshold = saved_karatsuba;
+        double dispatched = time_mul(a, b, repetitions);
+
+        std::printf("%8zu %16.3f %16.3f\n", sizes[i], schoolbook, dispatched);
+    }
+}
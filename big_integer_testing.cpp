@@ -3,6 +3,8 @@
 #include <cstdlib>
 #include <vector>
 #include <utility>
+#include <sstream>
+#include <thread>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
@@ -573,6 +575,33 @@ TEST(correctness, negation_long)
     EXPECT_EQ(a, -c);
 }
 
+TEST(correctness, add_sub_long_and_small)
+{
+    big_integer a("10000000000000000000000000000000");
+    big_integer b("-10000000000000000000000000000000");
+
+    EXPECT_EQ(a + 5, big_integer("10000000000000000000000000000005"));
+    EXPECT_EQ(a - 5, big_integer("9999999999999999999999999999995"));
+    EXPECT_EQ(b + 5, big_integer("-9999999999999999999999999999995"));
+    EXPECT_EQ(b - 5, big_integer("-10000000000000000000000000000005"));
+    EXPECT_EQ(5 - a, big_integer("-9999999999999999999999999999995"));
+    EXPECT_EQ(big_integer("4294967296") - 4294967, big_integer("4290672329"));
+    EXPECT_EQ(big_integer("4294967296") - big_integer("4294967297"), -1);
+    EXPECT_EQ(to_string(b * 0), "0");
+}
+
+TEST(correctness, compare_long_and_small)
+{
+    big_integer a("4294967296");
+
+    EXPECT_TRUE(a > 5);
+    EXPECT_TRUE(-a < 5);
+    EXPECT_TRUE(5 < a);
+    EXPECT_TRUE(-5 > -a);
+    EXPECT_FALSE(a == 5);
+    EXPECT_FALSE(big_integer(-1763148153) == big_integer("-2175504340372509755"));
+}
+
 TEST(correctness, string_conv)
 {
     EXPECT_EQ(to_string(big_integer("100")), "100");
@@ -690,3 +719,1383 @@ TEST(correctness, mul_merge_randomized)
         EXPECT_TRUE(a == b);
     }
 }
+
+namespace
+{
+    big_integer random_big_integer(size_t limbs)
+    {
+        big_integer result = 0;
+        for (size_t i = 0; i != limbs; ++i)
+        {
+            for (int bits = 0; bits < big_integer::LIMB_BITS; bits += 16)
+            {
+                result <<= 16;
+                result += rand() & 0xffff;
+            }
+        }
+        return (rand() % 2 == 0 ? result : -result);
+    }
+}
+
+TEST(correctness, mul_karatsuba_randomized)
+{
+    int const saved_threshold = big_integer::karatsuba_threshold;
+    size_t const sizes[] = {4, 5, 17, 64, 101, 300};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        for (size_t j = 0; j <= i; ++j)
+        {
+            big_integer a = random_big_integer(sizes[i]);
+            big_integer b = random_big_integer(sizes[j]);
+
+            big_integer::karatsuba_threshold = std::numeric_limits<int>::max();
+            big_integer expected = a * b;
+            big_integer::karatsuba_threshold = 4;
+            EXPECT_EQ(a * b, expected);
+            EXPECT_EQ(b * a, expected);
+        }
+    }
+
+    big_integer::karatsuba_threshold = saved_threshold;
+}
+
+namespace
+{
+    void expect_same_product_as_karatsuba(big_integer const& a, big_integer const& b)
+    {
+        int const saved_toom3 = big_integer::toom3_threshold;
+        int const saved_toom4 = big_integer::toom4_threshold;
+        int const saved_ntt = big_integer::ntt_threshold;
+
+        big_integer::ntt_threshold = std::numeric_limits<int>::max();
+        big_integer::toom3_threshold = std::numeric_limits<int>::max();
+        big_integer::toom4_threshold = std::numeric_limits<int>::max();
+        big_integer expected = a * b;
+
+        big_integer::toom3_threshold = 12;
+        EXPECT_EQ(a * b, expected);
+        big_integer::toom4_threshold = 16;
+        EXPECT_EQ(a * b, expected);
+        big_integer::toom3_threshold = std::numeric_limits<int>::max();
+        EXPECT_EQ(a * b, expected);
+
+        big_integer::toom3_threshold = saved_toom3;
+        big_integer::toom4_threshold = saved_toom4;
+        big_integer::ntt_threshold = saved_ntt;
+    }
+}
+
+TEST(correctness, mul_toom_randomized)
+{
+    size_t const sizes[] = {16, 17, 18, 19, 50, 200, 777};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        expect_same_product_as_karatsuba(random_big_integer(sizes[i]), random_big_integer(sizes[i]));
+        expect_same_product_as_karatsuba(random_big_integer(sizes[i]), random_big_integer(sizes[i] / 2 + 1));
+    }
+}
+
+TEST(correctness, mul_toom_sparse)
+{
+    big_integer a = (big_integer(1) << 3000) - 1;
+    big_integer b = (big_integer(1) << 2000) + 1;
+
+    expect_same_product_as_karatsuba(a, a);
+    expect_same_product_as_karatsuba(a, b);
+    expect_same_product_as_karatsuba(a, -b);
+    expect_same_product_as_karatsuba(big_integer(1) << 3100, b);
+}
+
+namespace
+{
+    void expect_same_product_as_schoolbook(big_integer const& a, big_integer const& b)
+    {
+        int const saved_karatsuba = big_integer::karatsuba_threshold;
+        int const saved_ntt = big_integer::ntt_threshold;
+
+        big_integer::karatsuba_threshold = std::numeric_limits<int>::max();
+        big_integer::ntt_threshold = std::numeric_limits<int>::max();
+        big_integer expected = a * b;
+
+        big_integer::karatsuba_threshold = saved_karatsuba;
+        big_integer::ntt_threshold = 1;
+        EXPECT_EQ(a * b, expected);
+
+        big_integer::ntt_threshold = saved_ntt;
+    }
+}
+
+TEST(correctness, mul_ntt_randomized)
+{
+    size_t const sizes[] = {4, 5, 33, 100, 1000, 2500};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        expect_same_product_as_schoolbook(random_big_integer(sizes[i]), random_big_integer(sizes[i]));
+        expect_same_product_as_schoolbook(random_big_integer(sizes[i]), random_big_integer(sizes[i] / 3 + 4));
+    }
+}
+
+TEST(correctness, mul_ntt_max_coefficients)
+{
+    big_integer a = (big_integer(1) << (big_integer::LIMB_BITS * 2048)) - 1;
+    big_integer b = (big_integer(1) << (big_integer::LIMB_BITS * 1500)) - 1;
+
+    expect_same_product_as_schoolbook(a, a);
+    expect_same_product_as_schoolbook(a, -b);
+}
+
+namespace
+{
+    void expect_square_equals_product(big_integer const& a)
+    {
+        big_integer distinct_copy(to_string(a));
+        big_integer expected = a * distinct_copy;
+
+        big_integer shared_copy = a;
+        EXPECT_EQ(a * a, expected);
+        EXPECT_EQ(a * shared_copy, expected);
+        shared_copy *= shared_copy;
+        EXPECT_EQ(shared_copy, expected);
+    }
+}
+
+TEST(correctness, sqr_randomized)
+{
+    int const saved_toom3 = big_integer::toom3_threshold;
+    int const saved_toom4 = big_integer::toom4_threshold;
+    int const saved_ntt = big_integer::ntt_threshold;
+    size_t const sizes[] = {1, 2, 3, 4, 5, 24, 25, 100, 101, 700};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        big_integer a = random_big_integer(sizes[i]);
+        expect_square_equals_product(a);
+
+        big_integer::toom3_threshold = 12;
+        expect_square_equals_product(a);
+        big_integer::toom4_threshold = 16;
+        expect_square_equals_product(a);
+        big_integer::ntt_threshold = 1;
+        expect_square_equals_product(a);
+
+        big_integer::toom3_threshold = saved_toom3;
+        big_integer::toom4_threshold = saved_toom4;
+        big_integer::ntt_threshold = saved_ntt;
+    }
+}
+
+TEST(correctness, sqr_signed)
+{
+    big_integer a("-10000000000000000000000000000000000000000000");
+    big_integer c( "100000000000000000000000000000000000000000000000000000000000000000000000000000000000000");
+
+    a *= a;
+    EXPECT_EQ(a, c);
+}
+
+namespace
+{
+    void expect_valid_division(big_integer const& a, big_integer const& b)
+    {
+        big_integer q = a / b;
+        big_integer r = a - q * b;
+
+        EXPECT_TRUE((r < 0 ? -r : r) < (b < 0 ? -b : b));
+        EXPECT_TRUE(r == 0 || (r < 0) == (a < 0));
+    }
+}
+
+TEST(correctness, div_randomized)
+{
+    size_t const sizes[] = {2, 3, 5, 17, 40, 130};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        for (size_t j = 0; j <= i; ++j)
+        {
+            big_integer a = random_big_integer(sizes[i]);
+            big_integer b = random_big_integer(sizes[j]);
+
+            expect_valid_division(a, b);
+            expect_valid_division(a * b + b / 2, b);
+            EXPECT_EQ(a * b / b, a);
+        }
+    }
+}
+
+TEST(correctness, div_extreme_limbs)
+{
+    int const bits = big_integer::LIMB_BITS;
+
+    for (int n = 2; n != 6; ++n)
+    {
+        big_integer ones = (big_integer(1) << (bits * n)) - 1;
+        big_integer top = big_integer(1) << (bits * n - 1);
+
+        expect_valid_division(ones * ones, ones);
+        expect_valid_division(ones * ones - 1, ones);
+        expect_valid_division(ones << (bits * 3), top + 1);
+        expect_valid_division((top + 1) * (ones - 1) + top, top + 1);
+        expect_valid_division(ones << bits, (ones >> (bits / 2)) + 1);
+        EXPECT_EQ((ones * ones) / ones, ones);
+        EXPECT_EQ((top * ones + top - 1) / top, ones);
+    }
+}
+
+namespace
+{
+    void expect_same_quotient_as_schoolbook(big_integer const& a, big_integer const& b)
+    {
+        int const saved_threshold = big_integer::burnikel_ziegler_threshold;
+        int const saved_newton = big_integer::newton_threshold;
+
+        big_integer::burnikel_ziegler_threshold = std::numeric_limits<int>::max();
+        big_integer::newton_threshold = std::numeric_limits<int>::max();
+        big_integer expected = a / b;
+        big_integer::burnikel_ziegler_threshold = 2;
+        EXPECT_EQ(a / b, expected);
+        big_integer::burnikel_ziegler_threshold = 5;
+        EXPECT_EQ(a / b, expected);
+        big_integer::newton_threshold = 2;
+        EXPECT_EQ(a / b, expected);
+        big_integer::newton_threshold = 7;
+        EXPECT_EQ(a / b, expected);
+        expect_valid_division(a, b);
+
+        big_integer::burnikel_ziegler_threshold = saved_threshold;
+        big_integer::newton_threshold = saved_newton;
+    }
+}
+
+TEST(correctness, div_burnikel_ziegler_randomized)
+{
+    size_t const sizes[] = {2, 3, 7, 16, 33, 100, 257};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        for (size_t j = 0; j <= i; ++j)
+        {
+            big_integer a = random_big_integer(sizes[i] + sizes[j]);
+            big_integer b = random_big_integer(sizes[j]);
+
+            expect_same_quotient_as_schoolbook(a, b);
+            expect_same_quotient_as_schoolbook(a * b, b);
+            expect_same_quotient_as_schoolbook(random_big_integer(sizes[i]), b);
+        }
+    }
+}
+
+TEST(correctness, div_burnikel_ziegler_extreme_limbs)
+{
+    int const bits = big_integer::LIMB_BITS;
+
+    for (int n = 4; n <= 64; n *= 2)
+    {
+        big_integer ones = (big_integer(1) << (bits * n)) - 1;
+        big_integer top = big_integer(1) << (bits * n - 1);
+
+        expect_same_quotient_as_schoolbook(ones * ones, ones);
+        expect_same_quotient_as_schoolbook(ones * ones - 1, ones);
+        expect_same_quotient_as_schoolbook((ones << (bits * 3)) + ones, top + 1);
+        expect_same_quotient_as_schoolbook((top + 1) * (ones - 1) + top, top + 1);
+        expect_same_quotient_as_schoolbook(ones << (bits * n), (ones >> (bits / 2)) + 1);
+    }
+}
+
+TEST(correctness, div_newton_randomized)
+{
+    int const saved_newton = big_integer::newton_threshold;
+    size_t const sizes[] = {60, 300, 1100};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        big_integer a = random_big_integer(3 * sizes[i] + 5);
+        big_integer b = random_big_integer(sizes[i]);
+
+        big_integer::newton_threshold = std::numeric_limits<int>::max();
+        big_integer expected = a / b;
+        big_integer::newton_threshold = 50;
+        EXPECT_EQ(a / b, expected);
+        EXPECT_EQ((a * b) / b, a);
+        expect_valid_division(a, b);
+    }
+
+    big_integer::newton_threshold = saved_newton;
+}
+
+namespace
+{
+    void expect_divmod_consistent(big_integer const& a, big_integer const& b)
+    {
+        std::pair<big_integer, big_integer> qr = divmod(a, b);
+
+        EXPECT_EQ(qr.first * b + qr.second, a);
+        EXPECT_EQ(a % b, qr.second);
+        expect_valid_division(a, b);
+        EXPECT_TRUE((qr.second < 0 ? -qr.second : qr.second) < (b < 0 ? -b : b));
+        EXPECT_TRUE(qr.second == 0 || (qr.second < 0) == (a < 0));
+    }
+}
+
+TEST(correctness, divmod_small)
+{
+    int const values[] = {0, 1, -1, 7, -7, 100, -100, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()};
+    size_t const n = sizeof(values) / sizeof(values[0]);
+
+    for (size_t i = 0; i != n; ++i)
+        for (size_t j = 0; j != n; ++j)
+            if (values[j] != 0)
+                expect_divmod_consistent(values[i], values[j]);
+
+    EXPECT_EQ(divmod(-7, 2).first, -3);
+    EXPECT_EQ(divmod(-7, 2).second, -1);
+    EXPECT_THROW(divmod(1, 0), std::runtime_error);
+}
+
+TEST(correctness, divmod_randomized)
+{
+    size_t const sizes[] = {1, 2, 5, 40, 150};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+        for (size_t j = 0; j <= i; ++j)
+        {
+            big_integer a = random_big_integer(2 * sizes[i] + 1);
+            big_integer b = random_big_integer(sizes[j]);
+
+            expect_divmod_consistent(a, b);
+            expect_divmod_consistent(-a, b);
+            expect_divmod_consistent(a, -b);
+            expect_divmod_consistent(b, a);
+            expect_divmod_consistent(a, std::rand() % 1000 + 1);
+            expect_divmod_consistent(-a, -(std::rand() % 1000 + 1));
+            expect_divmod_consistent(a * b, b);
+        }
+}
+
+TEST(correctness, mod_burnikel_ziegler_and_newton)
+{
+    int const saved_threshold = big_integer::burnikel_ziegler_threshold;
+    int const saved_newton = big_integer::newton_threshold;
+    big_integer a = random_big_integer(700);
+    big_integer b = random_big_integer(200);
+    big_integer expected = a - a / b * b;
+
+    big_integer::burnikel_ziegler_threshold = 5;
+    EXPECT_EQ(a % b, expected);
+    EXPECT_EQ(divmod(a, b).second, expected);
+    big_integer::newton_threshold = 50;
+    EXPECT_EQ(a % b, expected);
+    EXPECT_EQ(-a % b, -expected);
+
+    big_integer::burnikel_ziegler_threshold = saved_threshold;
+    big_integer::newton_threshold = saved_newton;
+}
+
+namespace
+{
+    void expect_same_as_operators(big_divisor const& d, big_integer const& a)
+    {
+        big_integer const& b = d.value();
+        std::pair<big_integer, big_integer> qr = d.divmod(a);
+
+        EXPECT_EQ(d.div(a), a / b);
+        EXPECT_EQ(d.mod(a), a % b);
+        EXPECT_EQ(qr.first, a / b);
+        EXPECT_EQ(qr.second, a % b);
+    }
+}
+
+TEST(correctness, big_divisor_small)
+{
+    int const values[] = {1, -1, 3, -10, 1 << 30, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()};
+
+    for (size_t i = 0; i != sizeof(values) / sizeof(values[0]); ++i)
+    {
+        big_divisor d(values[i]);
+        expect_same_as_operators(d, 0);
+        expect_same_as_operators(d, 12345);
+        expect_same_as_operators(d, std::numeric_limits<int>::min());
+        expect_same_as_operators(d, random_big_integer(5));
+        expect_same_as_operators(d, -random_big_integer(30));
+    }
+
+    EXPECT_THROW(big_divisor(0), std::runtime_error);
+}
+
+TEST(correctness, big_divisor_randomized)
+{
+    size_t const sizes[] = {1, 2, 3, 10, 45, 100};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        big_integer b = random_big_integer(sizes[i]) + 1;
+        big_divisor d(b);
+        big_divisor negative(-b);
+
+        for (size_t j = 0; j != 10; ++j)
+        {
+            big_integer a = random_big_integer(std::rand() % (3 * sizes[i]) + 1);
+            expect_same_as_operators(d, a);
+            expect_same_as_operators(negative, -a);
+            expect_same_as_operators(d, a * b);
+            expect_same_as_operators(negative, a * b - 1);
+        }
+    }
+}
+
+TEST(correctness, big_divisor_reciprocal)
+{
+    int const saved_threshold = big_divisor::reciprocal_threshold;
+    size_t const sizes[] = {3, 20, 150};
+
+    big_divisor::reciprocal_threshold = 3;
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        big_integer b = random_big_integer(sizes[i]);
+        big_divisor d(b);
+
+        for (size_t j = 0; j != 5; ++j)
+        {
+            big_integer a = random_big_integer(std::rand() % (4 * sizes[i]) + 1);
+            expect_same_as_operators(d, a);
+            expect_same_as_operators(d, -a);
+            expect_same_as_operators(d, a * b + b - 1);
+        }
+        expect_same_as_operators(d, (big_integer(1) << (int)(2 * sizes[i] * big_integer::LIMB_BITS)) - 1);
+    }
+
+    big_integer ones = (big_integer(1) << (8 * big_integer::LIMB_BITS)) - 1;
+    expect_same_as_operators(big_divisor(ones), ones * ones - 1);
+    expect_same_as_operators(big_divisor((ones >> 1) + 1), ones * ones);
+
+    big_divisor::reciprocal_threshold = saved_threshold;
+}
+
+namespace
+{
+    struct shared_division
+    {
+        big_divisor const* d;
+        big_integer const* dividends;
+        big_integer* remainders;
+        size_t count;
+
+        void operator()() const
+        {
+            for (size_t i = 0; i != count; ++i)
+                remainders[i] = d->mod(dividends[i]);
+        }
+    };
+}
+
+TEST(correctness, big_divisor_shared_between_threads)
+{
+    int const saved_threshold = big_divisor::reciprocal_threshold;
+    big_divisor::reciprocal_threshold = 3;
+
+    big_divisor d(random_big_integer(40));
+    std::vector<big_integer> dividends, expected;
+    for (size_t i = 0; i != 20; ++i)
+    {
+        dividends.push_back(random_big_integer(std::rand() % 120 + 41));
+        expected.push_back(dividends.back() % d.value());
+    }
+    std::vector<big_integer> first(dividends.size()), second(dividends.size());
+
+    shared_division one = {&d, &dividends[0], &first[0], dividends.size()};
+    shared_division two = {&d, &dividends[0], &second[0], dividends.size()};
+    std::thread worker(one);
+    two();
+    worker.join();
+
+    EXPECT_TRUE(first == expected);
+    EXPECT_TRUE(second == expected);
+
+    big_divisor::reciprocal_threshold = saved_threshold;
+}
+
+namespace
+{
+    big_integer non_negative_mod(big_integer const& a, big_integer const& m)
+    {
+        big_integer r = a % m;
+        return r < 0 ? r + m : r;
+    }
+}
+
+TEST(correctness, montgomery_small)
+{
+    montgomery ctx(101);
+
+    EXPECT_EQ(ctx.modulus(), 101);
+    for (int a = -150; a <= 150; a += 7)
+        for (int b = 0; b <= 150; b += 11)
+        {
+            big_integer x = ctx.to_montgomery(a);
+            big_integer y = ctx.to_montgomery(b);
+            EXPECT_EQ(ctx.from_montgomery(x), non_negative_mod(a, 101));
+            EXPECT_EQ(ctx.from_montgomery(ctx.mul(x, y)), non_negative_mod(big_integer(a) * b, 101));
+        }
+
+    EXPECT_EQ(montgomery(1).to_montgomery(12345), 0);
+    EXPECT_THROW(montgomery(100), std::runtime_error);
+    EXPECT_THROW(montgomery(-7), std::runtime_error);
+    EXPECT_THROW(montgomery(0), std::runtime_error);
+}
+
+TEST(correctness, montgomery_randomized)
+{
+    size_t const sizes[] = {1, 2, 3, 17, 40};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        big_integer m = random_big_integer(sizes[i]) | 1;
+        if (m < 0)
+            m = -m;
+        montgomery ctx(m);
+
+        for (size_t j = 0; j != 10; ++j)
+        {
+            big_integer a = random_big_integer(std::rand() % (2 * sizes[i]) + 1);
+            big_integer b = random_big_integer(std::rand() % (2 * sizes[i]) + 1);
+            big_integer x = ctx.to_montgomery(a);
+            big_integer y = ctx.to_montgomery(b);
+
+            EXPECT_EQ(ctx.from_montgomery(x), non_negative_mod(a, m));
+            EXPECT_EQ(ctx.from_montgomery(ctx.mul(x, y)), non_negative_mod(a * b, m));
+            EXPECT_EQ(ctx.from_montgomery(ctx.sqr(y)), non_negative_mod(b * b, m));
+        }
+
+        big_integer top = ctx.to_montgomery(m - 1);
+        EXPECT_EQ(ctx.from_montgomery(ctx.sqr(top)), 1);
+        EXPECT_EQ(ctx.from_montgomery(ctx.mul(top, ctx.to_montgomery(1))), m - 1);
+    }
+}
+
+namespace
+{
+    big_integer naive_powmod(big_integer base, big_integer exp, big_integer const& mod)
+    {
+        big_integer result = non_negative_mod(1, mod);
+        base = non_negative_mod(base, mod);
+        while (exp != 0)
+        {
+            if ((exp & 1) != 0)
+                result = result * base % mod;
+            base = base * base % mod;
+            exp >>= 1;
+        }
+        return result;
+    }
+}
+
+TEST(correctness, powmod_small)
+{
+    EXPECT_EQ(powmod(2, 10, 1000), 24);
+    EXPECT_EQ(powmod(3, 0, 7), 1);
+    EXPECT_EQ(powmod(3, 0, 1), 0);
+    EXPECT_EQ(powmod(0, 0, 5), 1);
+    EXPECT_EQ(powmod(-2, 3, 7), 6);
+    EXPECT_EQ(powmod(-2, 3, -7), 6);
+    EXPECT_EQ(powmod(5, 117, 1 << 20), naive_powmod(5, 117, 1 << 20));
+    EXPECT_EQ(powmod_sec(-2, 3, 7), 6);
+    EXPECT_EQ(powmod_sec(4, 0, 9), 1);
+
+    EXPECT_THROW(powmod(2, -1, 7), std::runtime_error);
+    EXPECT_THROW(powmod(2, 3, 0), std::runtime_error);
+    EXPECT_THROW(powmod_sec(2, 3, 8), std::runtime_error);
+}
+
+TEST(correctness, powmod_randomized)
+{
+    size_t const sizes[] = {1, 2, 5, 16};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+        for (size_t j = 0; j != 4; ++j)
+        {
+            big_integer mod = random_big_integer(sizes[i]);
+            big_integer base = random_big_integer(sizes[i] + 1);
+            big_integer exp = random_big_integer(std::rand() % 3 + 1);
+            if (exp < 0)
+                exp = -exp;
+            if (j % 2 == 0)
+                mod |= 1;
+            else
+                mod <<= 3;
+            if (mod < 0)
+                mod = -mod;
+
+            big_integer expected = naive_powmod(base, exp, mod);
+            EXPECT_EQ(powmod(base, exp, mod), expected);
+            if (j % 2 == 0)
+            {
+                EXPECT_EQ(powmod_sec(base, exp, mod), expected);
+            }
+        }
+}
+
+TEST(correctness, powmod_fermat)
+{
+    // 2^127 - 1 and 2^521 - 1 are prime
+    big_integer const p127 = (big_integer(1) << 127) - 1;
+    big_integer const p521 = (big_integer(1) << 521) - 1;
+    big_integer a = random_big_integer(4);
+    if (a < 0)
+        a = -a;
+
+    EXPECT_EQ(powmod(a, p127 - 1, p127), 1);
+    EXPECT_EQ(powmod(a, p521, p521), a % p521);
+    EXPECT_EQ(powmod_sec(a, p521 - 1, p521), 1);
+    EXPECT_EQ(powmod(a, p521 - 1, p521 * 2), naive_powmod(a, p521 - 1, p521 * 2));
+}
+
+TEST(correctness, barrett_small)
+{
+    barrett ctx(100);
+
+    EXPECT_EQ(ctx.modulus(), 100);
+    for (int x = -1000; x <= 1000; x += 37)
+        EXPECT_EQ(ctx.reduce(x), non_negative_mod(x, 100));
+    EXPECT_EQ(ctx.mul(99, 99), 1);
+    EXPECT_EQ(ctx.sqr(12), 44);
+    EXPECT_EQ(ctx.pow(3, 5), 43);
+    EXPECT_EQ(ctx.pow(3, 0), 1);
+    EXPECT_EQ(barrett(1).pow(5, 0), 0);
+
+    EXPECT_THROW(barrett(0), std::runtime_error);
+    EXPECT_THROW(barrett(-4), std::runtime_error);
+}
+
+TEST(correctness, barrett_randomized)
+{
+    size_t const sizes[] = {1, 2, 3, 10, 40};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        big_integer m = random_big_integer(sizes[i]);
+        if (m < 0)
+            m = -m;
+        barrett ctx(m);
+
+        for (size_t j = 0; j != 10; ++j)
+        {
+            big_integer x = random_big_integer(std::rand() % (5 * sizes[i]) + 1);
+            big_integer a = ctx.reduce(random_big_integer(sizes[i]));
+            big_integer b = ctx.reduce(random_big_integer(sizes[i]));
+
+            EXPECT_EQ(ctx.reduce(x), non_negative_mod(x, m));
+            EXPECT_EQ(ctx.reduce(m * x), 0);
+            EXPECT_EQ(ctx.mul(a, b), a * b % m);
+            EXPECT_EQ(ctx.sqr(a), a * a % m);
+        }
+        EXPECT_EQ(ctx.reduce(m * m - 1), m - 1);
+    }
+}
+
+TEST(correctness, barrett_power_of_base)
+{
+    // m = B^(k - 1) has the longest mu
+    for (int k = 1; k != 5; ++k)
+    {
+        big_integer m = big_integer(1) << ((k - 1) * big_integer::LIMB_BITS);
+        barrett ctx(m);
+        big_integer x = random_big_integer(2 * k);
+
+        EXPECT_EQ(ctx.reduce(x), non_negative_mod(x, m));
+        EXPECT_EQ(ctx.reduce(m * m - 1), m - 1);
+        EXPECT_EQ(ctx.pow(m - 1, 3), m == 1 ? 0 : m - 1);
+    }
+}
+
+namespace
+{
+    big_integer euclid_gcd(big_integer a, big_integer b)
+    {
+        if (a < 0)
+            a = -a;
+        if (b < 0)
+            b = -b;
+        while (b != 0)
+        {
+            big_integer r = a % b;
+            a = b;
+            b = r;
+        }
+        return a;
+    }
+}
+
+TEST(correctness, gcd_small)
+{
+    EXPECT_EQ(gcd(12, 18), 6);
+    EXPECT_EQ(gcd(-12, 18), 6);
+    EXPECT_EQ(gcd(12, -18), 6);
+    EXPECT_EQ(gcd(0, -7), 7);
+    EXPECT_EQ(gcd(7, 0), 7);
+    EXPECT_EQ(gcd(0, 0), 0);
+    EXPECT_EQ(gcd(std::numeric_limits<int>::min(), std::numeric_limits<int>::min()), big_integer(1) << 31);
+    EXPECT_EQ(gcd(17, 5), 1);
+}
+
+TEST(correctness, gcd_randomized)
+{
+    int const saved_threshold = big_integer::half_gcd_threshold;
+    int const thresholds[] = {saved_threshold, 4, 9};
+
+    for (size_t t = 0; t != sizeof(thresholds) / sizeof(thresholds[0]); ++t)
+    {
+        big_integer::half_gcd_threshold = thresholds[t];
+        for (size_t i = 0; i != 30; ++i)
+        {
+            big_integer g = random_big_integer(std::rand() % 4 + 1);
+            big_integer a = random_big_integer(std::rand() % 40 + 1) * g;
+            big_integer b = random_big_integer(std::rand() % 40 + 1) * g;
+
+            big_integer expected = euclid_gcd(a, b);
+            EXPECT_EQ(gcd(a, b), expected);
+            EXPECT_EQ(gcd(b, a), expected);
+            EXPECT_EQ(gcd(a, a), (a < 0 ? -a : a));
+            EXPECT_EQ(gcd(a * b, b), (b < 0 ? -b : b));
+        }
+    }
+
+    big_integer::half_gcd_threshold = saved_threshold;
+}
+
+TEST(correctness, gcd_fibonacci)
+{
+    // consecutive Fibonacci numbers have all Euclid quotients equal to one
+    int const saved_threshold = big_integer::half_gcd_threshold;
+    big_integer f0 = 0, f1 = 1;
+    for (int i = 0; i != 3000; ++i)
+    {
+        big_integer f2 = f0 + f1;
+        f0 = f1;
+        f1 = f2;
+    }
+
+    EXPECT_EQ(gcd(f1, f0), 1);
+    EXPECT_EQ(gcd(f1 * 6, f0 * 9), euclid_gcd(f1 * 6, f0 * 9));
+    big_integer::half_gcd_threshold = 4;
+    EXPECT_EQ(gcd(f1, f0), 1);
+    EXPECT_EQ(gcd(f1 << 100, f0 << 70), euclid_gcd(f1 << 100, f0 << 70));
+
+    big_integer::half_gcd_threshold = saved_threshold;
+}
+
+TEST(correctness, gcd_long)
+{
+    big_integer g = random_big_integer(50);
+    big_integer a = random_big_integer(400) * g;
+    big_integer b = random_big_integer(380) * g;
+
+    big_integer expected = euclid_gcd(a, b);
+    EXPECT_EQ(gcd(a, b), expected);
+    EXPECT_EQ(expected % g, 0);
+}
+
+namespace
+{
+    void expect_valid_gcdext(big_integer const& a, big_integer const& b)
+    {
+        big_integer g, s, t;
+        std::tie(g, s, t) = gcdext(a, b);
+
+        EXPECT_EQ(g, euclid_gcd(a, b));
+        EXPECT_EQ(s * a + t * b, g);
+        big_integer abs_b = (b < 0 ? -b : b);
+        if (g != 0 && abs_b != g && b != 0)
+        {
+            EXPECT_TRUE((s < 0 ? -s : s) * 2 * g <= abs_b);
+        }
+    }
+}
+
+TEST(correctness, gcdext_small)
+{
+    big_integer g, s, t;
+    std::tie(g, s, t) = gcdext(240, 46);
+    EXPECT_EQ(g, 2);
+    EXPECT_EQ(s, -9);
+    EXPECT_EQ(t, 47);
+
+    std::tie(g, s, t) = gcdext(0, 0);
+    EXPECT_EQ(g, 0);
+    EXPECT_EQ(s, 0);
+    EXPECT_EQ(t, 0);
+
+    std::tie(g, s, t) = gcdext(-5, 0);
+    EXPECT_EQ(g, 5);
+    EXPECT_EQ(s, -1);
+    EXPECT_EQ(t, 0);
+
+    int const values[] = {0, 1, -1, 6, -9, 35, 1 << 30, std::numeric_limits<int>::min()};
+    for (size_t i = 0; i != sizeof(values) / sizeof(values[0]); ++i)
+        for (size_t j = 0; j != sizeof(values) / sizeof(values[0]); ++j)
+            expect_valid_gcdext(values[i], values[j]);
+}
+
+TEST(correctness, gcdext_randomized)
+{
+    int const saved_threshold = big_integer::half_gcd_threshold;
+    int const thresholds[] = {saved_threshold, 4};
+
+    for (size_t k = 0; k != sizeof(thresholds) / sizeof(thresholds[0]); ++k)
+    {
+        big_integer::half_gcd_threshold = thresholds[k];
+        for (size_t i = 0; i != 20; ++i)
+        {
+            big_integer g = random_big_integer(std::rand() % 3 + 1);
+            big_integer a = random_big_integer(std::rand() % 30 + 1) * g;
+            big_integer b = random_big_integer(std::rand() % 30 + 1) * g;
+
+            expect_valid_gcdext(a, b);
+            expect_valid_gcdext(b, a);
+            expect_valid_gcdext(a, a * 3);
+        }
+    }
+
+    big_integer::half_gcd_threshold = saved_threshold;
+}
+
+TEST(correctness, invert)
+{
+    EXPECT_EQ(invert(3, 7), 5);
+    EXPECT_EQ(invert(-3, 7), 2);
+    EXPECT_EQ(invert(3, -7), 5);
+    EXPECT_EQ(invert(10, 1), 0);
+    EXPECT_THROW(invert(6, 9), std::runtime_error);
+    EXPECT_THROW(invert(0, 7), std::runtime_error);
+    EXPECT_THROW(invert(3, 0), std::runtime_error);
+
+    big_integer const p = (big_integer(1) << 521) - 1;
+    for (size_t i = 0; i != 10; ++i)
+    {
+        big_integer a = random_big_integer(std::rand() % 12 + 1);
+        if (a % p == 0)
+            continue;
+        big_integer inverse = invert(a, p);
+
+        EXPECT_TRUE(inverse >= 0 && inverse < p);
+        EXPECT_EQ(non_negative_mod(a * inverse, p), 1);
+        EXPECT_EQ(inverse, powmod(a, p - 2, p));
+    }
+}
+
+namespace
+{
+    big_integer power(big_integer const& a, int n)
+    {
+        big_integer result = 1;
+        for (int i = 0; i != n; ++i)
+            result *= a;
+        return result;
+    }
+
+    void expect_valid_root(big_integer const& a, int n)
+    {
+        big_integer r = iroot(a, n);
+        big_integer abs_a = (a < 0 ? -a : a);
+        big_integer abs_r = (r < 0 ? -r : r);
+
+        EXPECT_TRUE(power(abs_r, n) <= abs_a);
+        EXPECT_TRUE(power(abs_r + 1, n) > abs_a);
+        EXPECT_TRUE(r == 0 || (r < 0) == (a < 0));
+    }
+}
+
+TEST(correctness, isqrt_small)
+{
+    for (int a = 0; a != 5000; ++a)
+    {
+        big_integer s = isqrt(a);
+        EXPECT_TRUE(s * s <= a && (s + 1) * (s + 1) > a);
+    }
+    EXPECT_EQ(isqrt(std::numeric_limits<int>::max()), 46340);
+    EXPECT_THROW(isqrt(-1), std::runtime_error);
+}
+
+TEST(correctness, isqrt_randomized)
+{
+    size_t const sizes[] = {1, 2, 3, 7, 40, 300};
+
+    for (size_t i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+        for (size_t j = 0; j != 5; ++j)
+        {
+            big_integer a = random_big_integer(sizes[i]);
+            if (a < 0)
+                a = -a;
+            big_integer s = isqrt(a);
+
+            EXPECT_TRUE(s * s <= a && (s + 1) * (s + 1) > a);
+            EXPECT_EQ(isqrt(a * a), a);
+            EXPECT_EQ(isqrt(a * a - 1), a - 1);
+            EXPECT_EQ(isqrt((a + 1) * (a + 1) - 1), a);
+        }
+
+    big_integer top = (big_integer(1) << (4 * big_integer::LIMB_BITS)) - 1;
+    EXPECT_EQ(isqrt(top), (big_integer(1) << (2 * big_integer::LIMB_BITS)) - 1);
+}
+
+TEST(correctness, iroot)
+{
+    int const degrees[] = {1, 2, 3, 5, 10, 64, 200};
+
+    for (size_t i = 0; i != sizeof(degrees) / sizeof(degrees[0]); ++i)
+    {
+        int n = degrees[i];
+        for (size_t j = 0; j != 4; ++j)
+        {
+            big_integer a = random_big_integer(std::rand() % 30 + 1);
+            if (a < 0 && n % 2 == 0)
+                a = -a;
+            expect_valid_root(a, n);
+
+            big_integer y = random_big_integer(std::rand() % 3 + 1);
+            if (y < 0 && n % 2 == 0)
+                y = -y;
+            if (n <= 10)
+            {
+                EXPECT_EQ(iroot(power(y, n), n), y);
+                expect_valid_root(power(y, n) - 1, n);
+            }
+        }
+    }
+
+    EXPECT_EQ(iroot(0, 7), 0);
+    EXPECT_EQ(iroot(-27, 3), -3);
+    EXPECT_EQ(iroot(-26, 3), -2);
+    EXPECT_EQ(iroot(1000, 1000), 1);
+    EXPECT_THROW(iroot(5, 0), std::runtime_error);
+    EXPECT_THROW(iroot(-16, 4), std::runtime_error);
+}
+
+TEST(correctness, is_probable_prime_small)
+{
+    int const limit = 1100000;
+    std::vector<bool> composite(limit, false);
+    composite[0] = composite[1] = true;
+    for (int p = 2; p * p < limit; ++p)
+        if (!composite[p])
+            for (int q = p * p; q < limit; q += p)
+                composite[q] = true;
+
+    for (int n = -5; n < 30000; ++n)
+        EXPECT_EQ(is_probable_prime(n), n >= 0 && !composite[n]);
+    for (int n = 1024 * 1024 - 3000; n < limit; ++n)
+        EXPECT_EQ(is_probable_prime(n), !composite[n]);
+}
+
+TEST(correctness, is_probable_prime_pseudoprimes)
+{
+    // strong pseudoprimes to base 2, the first two the squares of Wieferich primes
+    char const* composites[] = {"1194649", "12327121", "25326001", "3825123056546413051",
+                                "318665857834031151167461", "3317044064679887385961981"};
+
+    for (size_t i = 0; i != sizeof(composites) / sizeof(composites[0]); ++i)
+    {
+        big_integer n(composites[i]);
+        EXPECT_FALSE(is_probable_prime(n));
+        EXPECT_FALSE(is_probable_prime(n, 10));
+        EXPECT_TRUE(powmod(2, n - 1, n) == 1);
+    }
+}
+
+TEST(correctness, is_probable_prime_mersenne)
+{
+    int const exponents[] = {2, 3, 5, 7, 13, 17, 19, 31, 61, 89, 107, 127, 521, 607, 1279};
+
+    for (size_t i = 0; i != sizeof(exponents) / sizeof(exponents[0]); ++i)
+    {
+        big_integer p = (big_integer(1) << exponents[i]) - 1;
+        EXPECT_TRUE(is_probable_prime(p, 3));
+        EXPECT_FALSE(is_probable_prime(-p));
+        if (exponents[i] > 31)
+        {
+            EXPECT_FALSE(is_probable_prime(p * p));
+            EXPECT_FALSE(is_probable_prime(p * ((big_integer(1) << 127) - 1)));
+            EXPECT_FALSE(is_probable_prime((big_integer(1) << (exponents[i] + 2)) - 1));
+        }
+    }
+    EXPECT_FALSE(is_probable_prime((big_integer(1) << 128) + 1));
+}
+
+TEST(correctness, factorial)
+{
+    big_integer expected = 1;
+
+    for (int n = 0; n <= 2000; ++n)
+    {
+        if (n > 0)
+            expected *= n;
+        if (n <= 300 || n % 97 == 0)
+        {
+            EXPECT_EQ(factorial(n), expected);
+        }
+    }
+    EXPECT_EQ(factorial(20), big_integer("2432902008176640000"));
+    EXPECT_EQ(factorial(30000) / factorial(29999), 30000);
+    EXPECT_THROW(factorial(-1), std::runtime_error);
+}
+
+TEST(correctness, binomial)
+{
+    std::vector<big_integer> row(1, 1);
+
+    for (int n = 0; n <= 150; ++n)
+    {
+        for (int k = 0; k <= n; ++k)
+            EXPECT_EQ(binomial(n, k), row[k]);
+        EXPECT_EQ(binomial(n, -1), 0);
+        EXPECT_EQ(binomial(n, n + 1), 0);
+
+        std::vector<big_integer> next(n + 2, 1);
+        for (int k = 1; k <= n; ++k)
+            next[k] = row[k - 1] + row[k];
+        row.swap(next);
+    }
+
+    for (size_t i = 0; i != 10; ++i)
+    {
+        int n = std::rand() % 5000;
+        int k = std::rand() % (n + 1);
+        EXPECT_EQ(binomial(n, k) * factorial(k) * factorial(n - k), factorial(n));
+    }
+
+    EXPECT_EQ(binomial(1000000, 3), big_integer("166666166667000000"));
+    EXPECT_EQ(binomial(-5, 3), -35);
+    EXPECT_EQ(binomial(-5, 2), 15);
+    EXPECT_EQ(binomial(-5, -2), 0);
+}
+
+TEST(correctness, primorial)
+{
+    big_integer expected = 1;
+
+    for (int n = -3; n <= 3000; ++n)
+    {
+        if (n > 0 && is_probable_prime(n))
+            expected *= n;
+        EXPECT_EQ(primorial(n), expected);
+    }
+    EXPECT_EQ(primorial(30), big_integer("6469693230"));
+}
+
+TEST(correctness, product)
+{
+    std::vector<big_integer> x;
+    for (size_t i = 0; i != number_of_multipliers; ++i)
+        x.push_back(myrand());
+    for (size_t i = 0; i != 20; ++i)
+        x.push_back(random_big_integer(std::rand() % 200 + 1));
+    std::random_shuffle(x.begin(), x.end());
+
+    big_integer expected = 1;
+    for (size_t i = 0; i != x.size(); ++i)
+        expected *= x[i];
+
+    EXPECT_EQ(product(x), expected);
+    EXPECT_EQ(product(x.begin(), x.end()), expected);
+    EXPECT_EQ(product(x, 4), expected);
+    EXPECT_EQ(product(x.begin() + 1, x.begin() + 1), 1);
+
+    int const small[] = {-3, 5, 7, -11};
+    EXPECT_EQ(product(small, small + 4), 1155);
+
+    x.push_back(0);
+    EXPECT_EQ(product(x, 3), 0);
+}
+
+TEST(correctness, product_threads)
+{
+    int const saved_threshold = big_integer::parallel_product_threshold;
+    big_integer::parallel_product_threshold = 1;
+
+    // copies of one value share its limbs between the subtrees
+    std::vector<big_integer> x(64, random_big_integer(50));
+    for (size_t i = 0; i != 64; ++i)
+        x.push_back(random_big_integer(std::rand() % 20 + 1));
+
+    big_integer expected = product(x);
+    for (int threads = 2; threads <= 8; ++threads)
+        EXPECT_EQ(product(x, threads), expected);
+
+    big_integer::parallel_product_threshold = saved_threshold;
+}
+
+TEST(correctness, to_string_divide_and_conquer)
+{
+    int const saved_threshold = big_integer::decimal_threshold;
+
+    for (size_t i = 0; i != 40; ++i)
+    {
+        big_integer a = random_big_integer(std::rand() % 150 + 1);
+        if (i % 4 == 0)
+            a >>= std::rand() % 64 + 1;
+
+        big_integer::decimal_threshold = std::numeric_limits<int>::max();
+        std::string expected = to_string(a);
+        big_integer::decimal_threshold = 2;
+        EXPECT_EQ(to_string(a), expected);
+        EXPECT_EQ(big_integer(expected), a);
+    }
+
+    big_integer::decimal_threshold = 2;
+    big_integer power = 1;
+    for (int digits = 1; digits <= 1000; ++digits)
+    {
+        power *= 10;
+        EXPECT_EQ(to_string(power), "1" + std::string(digits, '0'));
+        EXPECT_EQ(to_string(power - 1), std::string(digits, '9'));
+        EXPECT_EQ(to_string(-power - 1), "-1" + std::string(digits - 1, '0') + "1");
+    }
+
+    big_integer::decimal_threshold = saved_threshold;
+}
+
+TEST(correctness, string_constructor_divide_and_conquer)
+{
+    int const saved_threshold = big_integer::decimal_threshold;
+    int const thresholds[] = {2, 3, saved_threshold};
+
+    for (size_t t = 0; t != sizeof(thresholds) / sizeof(thresholds[0]); ++t)
+    {
+        big_integer::decimal_threshold = thresholds[t];
+        for (size_t i = 0; i != 30; ++i)
+        {
+            std::string digits(1, (char)('1' + std::rand() % 9));
+            int length = std::rand() % 2000;
+            for (int j = 0; j < length; ++j)
+                digits += (char)('0' + std::rand() % 10);
+
+            big_integer expected = 0;
+            for (size_t j = 0; j != digits.size(); ++j)
+                expected = expected * 10 + (digits[j] - '0');
+
+            EXPECT_EQ(big_integer(digits), expected);
+            EXPECT_EQ(big_integer("-000" + digits), -expected);
+        }
+        EXPECT_EQ(big_integer("1" + std::string(1000, '0')), power(10, 1000));
+        EXPECT_EQ(big_integer(std::string(1000, '9')), power(10, 1000) - 1);
+    }
+
+    big_integer::decimal_threshold = saved_threshold;
+}
+
+namespace
+{
+    std::string naive_to_string(big_integer a, int radix)
+    {
+        bool negative = a < 0;
+        if (negative)
+            a = -a;
+        std::string result;
+        do
+        {
+            result += "0123456789abcdefghijklmnopqrstuvwxyz"[std::atoi(to_string(a % radix).c_str())];
+            a /= radix;
+        } while (a != 0);
+        if (negative)
+            result += '-';
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+}
+
+TEST(correctness, radix_conversion)
+{
+    int const saved_threshold = big_integer::decimal_threshold;
+
+    for (int radix = 2; radix <= 36; ++radix)
+        for (size_t i = 0; i != 6; ++i)
+        {
+            big_integer a = (i == 0 ? big_integer(0) : random_big_integer(std::rand() % (i < 3 ? 2 : 40) + 1));
+            big_integer::decimal_threshold = (i % 2 == 0 ? 2 : saved_threshold);
+            std::string s = to_string(a, radix);
+
+            EXPECT_EQ(s, naive_to_string(a, radix));
+            EXPECT_EQ(big_integer(s, radix), a);
+        }
+    big_integer::decimal_threshold = saved_threshold;
+
+    big_integer a = random_big_integer(500);
+    EXPECT_EQ(big_integer(to_string(a, 7), 7), a);
+    EXPECT_EQ(big_integer(to_string(a, 32), 32), a);
+    EXPECT_EQ(to_string(a, 10), to_string(a));
+
+    EXPECT_EQ(to_string(big_integer(255), 16), "ff");
+    EXPECT_EQ(to_string(big_integer(-8), 8), "-10");
+    EXPECT_EQ(to_string(big_integer(1) << 64, 16), "1" + std::string(16, '0'));
+    EXPECT_EQ(big_integer("DeadBeef", 16), big_integer("3735928559"));
+    EXPECT_EQ(big_integer("-0000101", 2), -5);
+    EXPECT_EQ(big_integer("zz", 36), 36 * 36 - 1);
+
+    EXPECT_THROW(big_integer("12", 1), std::runtime_error);
+    EXPECT_THROW(big_integer("12", 37), std::runtime_error);
+    EXPECT_THROW(big_integer("102", 2), std::runtime_error);
+    EXPECT_THROW(big_integer("-", 10), std::runtime_error);
+    EXPECT_THROW(big_integer("", 16), std::runtime_error);
+    EXPECT_THROW(big_integer("1 2", 10), std::runtime_error);
+    EXPECT_THROW(to_string(big_integer(5), 0), std::runtime_error);
+}
+
+TEST(correctness, to_chars)
+{
+    char buffer[4000];
+
+    for (int base = 2; base <= 36; ++base)
+        for (size_t i = 0; i != 8; ++i)
+        {
+            big_integer a = (i == 0 ? big_integer(0) : random_big_integer(std::rand() % (i < 4 ? 2 : 30) + 1));
+            std::string expected = to_string(a, base);
+
+            to_chars_result result = to_chars(buffer, buffer + sizeof(buffer), a, base);
+            EXPECT_TRUE(result.ec == std::errc());
+            EXPECT_EQ(std::string(buffer, result.ptr), expected);
+            EXPECT_EQ(to_chars_length(a, base), expected.size());
+
+            result = to_chars(buffer, buffer + expected.size() - 1, a, base);
+            EXPECT_TRUE(result.ec == std::errc::value_too_large);
+            EXPECT_TRUE(result.ptr == buffer + expected.size() - 1);
+        }
+
+    big_integer power = 1;
+    for (int digits = 1; digits <= 1000; ++digits)
+    {
+        power *= 10;
+        EXPECT_EQ(to_chars_length(power), (size_t)digits + 1);
+        EXPECT_EQ(to_chars_length(power - 1), (size_t)digits);
+        EXPECT_EQ(to_chars_length(1 - power), (size_t)digits + 1);
+    }
+    EXPECT_THROW(to_chars(buffer, buffer + 10, 5, 37), std::runtime_error);
+}
+
+TEST(correctness, from_chars)
+{
+    for (int base = 2; base <= 36; ++base)
+        for (size_t i = 0; i != 8; ++i)
+        {
+            big_integer a = (i == 0 ? big_integer(0) : random_big_integer(std::rand() % (i < 4 ? 2 : 30) + 1));
+            std::string text = to_string(a, base) + "!";
+
+            big_integer b = 17;
+            from_chars_result result = from_chars(text.data(), text.data() + text.size(), b, base);
+            EXPECT_TRUE(result.ec == std::errc());
+            EXPECT_TRUE(result.ptr == text.data() + text.size() - 1);
+            EXPECT_EQ(b, a);
+        }
+
+    std::string const text = "-00123abc";
+    big_integer a = 42;
+    from_chars_result result = from_chars(text.data(), text.data() + text.size(), a);
+    EXPECT_TRUE(result.ptr == text.data() + 6);
+    EXPECT_EQ(a, -123);
+    result = from_chars(text.data(), text.data() + text.size(), a, 16);
+    EXPECT_TRUE(result.ptr == text.data() + text.size());
+    EXPECT_EQ(a, -0x123abc);
+
+    std::string const invalid[] = {"", "-", "+1", " 1", "-x"};
+    for (size_t i = 0; i != sizeof(invalid) / sizeof(invalid[0]); ++i)
+    {
+        big_integer b = 42;
+        result = from_chars(invalid[i].data(), invalid[i].data() + invalid[i].size(), b);
+        EXPECT_TRUE(result.ec == std::errc::invalid_argument);
+        EXPECT_TRUE(result.ptr == invalid[i].data());
+        EXPECT_EQ(b, 42);
+    }
+
+    std::string const borders[] = {"2147483647", "-2147483648", "2147483648", "-2147483649", "18446744073709551615"};
+    for (size_t i = 0; i != sizeof(borders) / sizeof(borders[0]); ++i)
+    {
+        from_chars(borders[i].data(), borders[i].data() + borders[i].size(), a);
+        EXPECT_EQ(a, big_integer(borders[i]));
+    }
+}
+
+TEST(correctness, big_integer_parser)
+{
+    int const saved_threshold = big_integer::decimal_threshold;
+    int const thresholds[] = {2, saved_threshold};
+    int const radices[] = {10, 16, 7};
+
+    for (size_t t = 0; t != sizeof(thresholds) / sizeof(thresholds[0]); ++t)
+        for (size_t r = 0; r != sizeof(radices) / sizeof(radices[0]); ++r)
+            for (size_t i = 0; i != 10; ++i)
+            {
+                big_integer::decimal_threshold = thresholds[t];
+                big_integer expected = random_big_integer(std::rand() % 150 + 1);
+                if (i == 0 && expected < 0)
+                    expected = -expected;
+                std::string text = (i == 0 ? "000" : "") + to_string(expected, radices[r]);
+
+                big_integer_parser parser(radices[r]);
+                for (size_t pos = 0; pos < text.size();)
+                {
+                    size_t piece = std::min((size_t)(std::rand() % 50), text.size() - pos);
+                    EXPECT_TRUE(parser.feed(text.data() + pos, text.data() + pos + piece) == text.data() + pos + piece);
+                    pos += piece;
+                }
+                EXPECT_TRUE(parser.has_digits());
+                EXPECT_EQ(parser.value(), expected);
+            }
+    big_integer::decimal_threshold = saved_threshold;
+
+    big_integer_parser parser;
+    EXPECT_FALSE(parser.has_digits());
+    EXPECT_EQ(parser.value(), 0);
+    std::string const text = "-12-3";
+    EXPECT_TRUE(parser.feed(text.data(), text.data() + text.size()) == text.data() + 3);
+    EXPECT_EQ(parser.value(), -12);
+
+    big_integer_parser plus;
+    std::string const plus_text = "+42+";
+    EXPECT_TRUE(plus.feed(plus_text.data(), plus_text.data() + plus_text.size()) == plus_text.data() + 3);
+    EXPECT_EQ(plus.value(), 42);
+
+    big_integer_parser prefixed(16);
+    std::string const prefixed_text = "-0x1fx";
+    EXPECT_TRUE(prefixed.feed(prefixed_text.data(), prefixed_text.data() + 4) == prefixed_text.data() + 4);
+    EXPECT_TRUE(prefixed.feed(prefixed_text.data() + 4, prefixed_text.data() + prefixed_text.size())
+                == prefixed_text.data() + 5);
+    EXPECT_EQ(prefixed.value(), -31);
+    EXPECT_THROW(big_integer_parser(1), std::runtime_error);
+}
+
+TEST(correctness, stream_extraction)
+{
+    std::string const long_digits = to_string(random_big_integer(300));
+    std::istringstream in("  -123\n+456 " + long_digits + " 0x12");
+    big_integer a, b, c, d;
+
+    in >> a >> b >> c >> d;
+    EXPECT_EQ(a, -123);
+    EXPECT_EQ(b, 456);
+    EXPECT_EQ(c, big_integer(long_digits));
+    EXPECT_EQ(d, 0);
+    EXPECT_TRUE(in.good());
+
+    // the 0x prefix is only read in hex, the x is left for the next extraction
+    d = 5;
+    in >> d;
+    EXPECT_TRUE(in.fail());
+    EXPECT_EQ(d, 5);
+
+    std::istringstream hex("ff -DeadBeef +0x10 -0XA 0x");
+    hex >> std::hex >> a >> b >> c >> d;
+    EXPECT_EQ(a, 255);
+    EXPECT_EQ(b, big_integer("-3735928559"));
+    EXPECT_EQ(c, 16);
+    EXPECT_EQ(d, -10);
+    hex >> a;
+    EXPECT_EQ(a, 0);
+    EXPECT_TRUE(hex.eof());
+    EXPECT_FALSE(hex.fail());
+
+    std::istringstream empty("   ");
+    empty >> a;
+    EXPECT_TRUE(empty.fail());
+    EXPECT_EQ(a, 0);
+}